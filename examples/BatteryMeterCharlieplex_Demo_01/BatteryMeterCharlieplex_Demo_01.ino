@@ -0,0 +1,63 @@
+#include "BatteryMeterCharlieplex.h"
+#include "MomentaryButton.h"
+
+// DESCRIPTION
+// This example shows how to run a battery meter with the output lights Charlieplexed on the Arduino
+// pins.  Four pins drive up to twelve lights, so a ten light meter only needs four pins.
+//
+// Activates using a momentary button.
+
+// CONFIGURATION
+// These items should be set to the values according to how you set your Arduino up.
+
+// The LEVEL of the battery meter is the number of levels/divisions/lights that you have on your
+// meter.  So LEVEL10 is for ten lights.
+Battery::LEVEL level = Battery::LEVEL10;
+
+// The pins the lights are connected between.  Each pin needs a current limiting resistor.  See
+// BatteryMeterCharlieplex.h for how the lights are wired.
+unsigned int lightPins[]	= {8, 9, 10, 11};
+uint8_t numberOfPins		= 4;
+
+unsigned int sensePin		= A0;
+unsigned int activationPin	= 5;
+
+// Set the min and max reading values that correspond to 2.7 and 4.2 volts (for a lithium battery).
+// If you don't know what values to use, run the battery meter and with 2.7 volts connected and again
+// with 4.2 volts, while using debug messages, and note the readings.
+int batteryMin	= 650;
+int batteryMax	= 975;
+
+// EXAMPLE STARTS HERE
+// Now we use all the items from the configuration section to build and run the example.
+
+BatteryMeterCharlieplex batteryMeter(batteryMin, batteryMax, level);
+
+// Create the button which determines when the meter is active.
+MomentaryButton activationButton(activationPin);
+
+void setup()
+{
+	#ifdef BATTERYMETERDEBUG
+		Serial.begin(9600);
+	#endif
+
+	// Set the input sensing pin.
+	batteryMeter.setSensingPin(sensePin);
+
+	// Set the pins the lights are connected between.
+	batteryMeter.setCharlieplexPins(lightPins, numberOfPins);
+
+	// Add the button.
+	batteryMeter.setActivationButton(activationButton);
+
+	// Run the battery meter setup.
+	batteryMeter.begin();
+}
+
+void loop()
+{
+	// Update also refreshes the lights, one row per call.  Keep the loop short (or call refresh from a
+	// timer interrupt and turn this off with setRefreshInUpdate(false)) so the lights don't flicker.
+	batteryMeter.update();
+}
\ No newline at end of file
@@ -0,0 +1,43 @@
+/*
+	The pin output of BatteryMeterPins on BatteryMeterWithOutput, the base class that reaches the output through a
+	virtual setLights (and has a virtual begin and setLightPins), to compare it with BatteryMeterWithStaticOutput.
+	Every instance carries a vtable pointer and every call is indirect.
+*/
+
+#ifndef BATTERYMETERPINSVIRTUAL_H
+#define BATTERYMETERPINSVIRTUAL_H
+
+#include <Arduino.h>
+#include "BatteryMeterWithOutput.h"
+
+class BatteryMeterPinsVirtual : public BatteryMeterWithOutput
+{
+	public:
+		BatteryMeterPinsVirtual(unsigned int batteryMin, unsigned int batteryMax, Battery::LEVEL level) :
+			BatteryMeterWithOutput(batteryMin, batteryMax, level)
+		{
+		}
+
+		void setLightPins(unsigned int ledPins[], uint8_t ledOnLevel)
+		{
+			BatteryMeterWithOutput::setLightPins(ledPins, ledOnLevel);
+
+			for (int i = 0; i < _maxLevel; i++)
+			{
+				pinMode(_ledPins[i], OUTPUT);
+				digitalWrite(_ledPins[i], _ledOnLevel == LOW ? HIGH : LOW);
+			}
+		}
+
+	private:
+		void setLights(Battery::LEVEL level)
+		{
+			uint8_t ledOffLevel = _ledOnLevel == LOW ? HIGH : LOW;
+			for (int i = 0; i < _maxLevel; i++)
+			{
+				digitalWrite(_ledPins[i], i < level ? _ledOnLevel : ledOffLevel);
+			}
+		}
+};
+
+#endif
@@ -0,0 +1,80 @@
+// DESCRIPTION
+// This sketch is used by footprint.sh to measure how much flash and RAM the library uses.  It is not an example.
+// The configuration is selected with defines passed to the compiler:
+//		FOOTPRINT_METER			0 = BatteryMeter, 1 = BatteryMeterPins, 2 = BatteryMeterShiftRegister,
+//								3 = BatteryMeterPinsVirtual (the virtual function design, for comparison).
+//		FOOTPRINT_LEVEL			The LEVEL for BatteryMeterPins and BatteryMeterPinsVirtual (1 to 10).
+//		FOOTPRINT_REGISTERS		The number of shift registers for BatteryMeterShiftRegister (1 to 4).
+//		BATTERYMETERDEBUG		Turns on the debugging messages.
+
+#ifndef FOOTPRINT_METER
+	#define FOOTPRINT_METER 0
+#endif
+
+#ifndef FOOTPRINT_LEVEL
+	#define FOOTPRINT_LEVEL 5
+#endif
+
+#ifndef FOOTPRINT_REGISTERS
+	#define FOOTPRINT_REGISTERS 1
+#endif
+
+#if FOOTPRINT_METER == 0
+	#include "BatteryMeter.h"
+
+	BatteryMeter batteryMeter(550, 850, Battery::LEVEL5);
+#else
+	#include "MomentaryButton.h"
+
+	MomentaryButton activationButton(5);
+
+	#if FOOTPRINT_METER == 1
+		#include "BatteryMeterPins.h"
+
+		unsigned int lightPins[]	= {2, 3, 4, 6, 7, 8, 9, 10, 11, 12};
+
+		BatteryMeterPins batteryMeter(550, 850, (Battery::LEVEL)FOOTPRINT_LEVEL);
+	#elif FOOTPRINT_METER == 3
+		#include "BatteryMeterPinsVirtual.h"
+
+		unsigned int lightPins[]	= {2, 3, 4, 6, 7, 8, 9, 10, 11, 12};
+
+		BatteryMeterPinsVirtual batteryMeter(550, 850, (Battery::LEVEL)FOOTPRINT_LEVEL);
+	#else
+		#include "BatteryMeterShiftRegister.h"
+
+		// Use every output on the shift registers, up to the largest LEVEL.
+		#define FOOTPRINT_SHIFTLEVEL (8*FOOTPRINT_REGISTERS < 10 ? 8*FOOTPRINT_REGISTERS : 10)
+
+		unsigned int lightPins[]	= {0, 1, 2, 3, 4, 5, 6, 7, 8, 9};
+
+		ShiftRegister74HC595<FOOTPRINT_REGISTERS> shiftRegister(2, 3, 4);
+		BatteryMeterShiftRegister<FOOTPRINT_REGISTERS> batteryMeter(&shiftRegister, 550, 850, (Battery::LEVEL)FOOTPRINT_SHIFTLEVEL);
+	#endif
+#endif
+
+void setup()
+{
+	#ifdef BATTERYMETERDEBUG
+		Serial.begin(9600);
+	#endif
+
+	batteryMeter.setSensingPin(A0);
+
+	#if FOOTPRINT_METER != 0
+		batteryMeter.setLightPins(lightPins, HIGH);
+		batteryMeter.setActivationButton(activationButton);
+	#endif
+
+	batteryMeter.begin();
+}
+
+void loop()
+{
+	#if FOOTPRINT_METER == 0
+		// Use the results so they are not optimized away.
+		analogWrite(9, batteryMeter.getBatteryLevel() + batteryMeter.getBatteryPercentage());
+	#else
+		batteryMeter.update();
+	#endif
+}
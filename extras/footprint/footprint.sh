@@ -0,0 +1,109 @@
+#!/bin/sh
+#
+# Builds the library in a matrix of configurations and reports the size of each.  Fails if any configuration
+# is over its budget in budgets.txt.
+#
+#	Usage:  extras/footprint/footprint.sh [board ...]
+#
+# The boards are arduino-cli FQBNs.  The default is every board in budgets.txt.  The cores for the boards,
+# and the SoftTimers, ButtonSuite, and ShiftRegister74HC595 libraries, must be installed in arduino-cli.
+# The size tool comes from the board's toolchain.  Set AVR_SIZE or ARM_SIZE if it is not on the path.
+
+FOOTPRINT_DIR=$(cd "$(dirname "$0")" && pwd)
+LIBRARY_DIR=$(cd "$FOOTPRINT_DIR/../.." && pwd)
+SKETCH="$FOOTPRINT_DIR/Footprint"
+BUDGETS="$FOOTPRINT_DIR/budgets.txt"
+BUILD_DIR=$(mktemp -d)
+trap 'rm -rf "$BUILD_DIR"' EXIT
+
+BOARDS="$*"
+if [ -z "$BOARDS" ]; then
+	BOARDS=$(grep -v '^#' "$BUDGETS" | awk 'NF { print $1 }' | uniq)
+fi
+
+# Configuration name and the defines that select it.
+configurations()
+{
+	for debug in 0 1; do
+		if [ $debug -eq 1 ]; then
+			suffix="-debug"
+			flags="-DBATTERYMETERDEBUG"
+		else
+			suffix=""
+			flags=""
+		fi
+
+		echo "BatteryMeter$suffix -DFOOTPRINT_METER=0 $flags"
+		for level in 1 2 3 4 5 6 7 8 9 10; do
+			echo "BatteryMeterPins-LEVEL$level$suffix -DFOOTPRINT_METER=1 -DFOOTPRINT_LEVEL=$level $flags"
+		done
+		echo "BatteryMeterPinsVirtual-LEVEL5$suffix -DFOOTPRINT_METER=3 -DFOOTPRINT_LEVEL=5 $flags"
+		for registers in 1 2 3 4; do
+			echo "BatteryMeterShiftRegister-$registers$suffix -DFOOTPRINT_METER=2 -DFOOTPRINT_REGISTERS=$registers $flags"
+		done
+	done
+}
+
+# Prints the flash and ram budget for a board and configuration.  The configuration in budgets.txt may use * to
+# match any characters.
+budget()
+{
+	grep -v '^#' "$BUDGETS" | awk -v board="$1" -v config="$2" \
+		'$1 == board { pattern = $2; gsub(/\*/, ".*", pattern); if (config ~ ("^" pattern "$")) { print $3, $4; exit } }'
+}
+
+size_tool()
+{
+	case "$1" in
+		arduino:avr:*)	echo "${AVR_SIZE:-avr-size}" ;;
+		*)				echo "${ARM_SIZE:-arm-none-eabi-size}" ;;
+	esac
+}
+
+for board in $BOARDS; do
+	size=$(size_tool "$board")
+
+	echo ""
+	echo "$board"
+	printf "%-36s %8s %8s %8s %8s %8s  %s\n" "Configuration" ".text" ".data" ".bss" "Flash" "RAM" "Budget"
+
+	configurations | while read -r name flags; do
+		output="$BUILD_DIR/$board/$name"
+		mkdir -p "$output"
+
+		if ! arduino-cli compile --fqbn "$board" --library "$LIBRARY_DIR" \
+			--build-property "compiler.cpp.extra_flags=$flags" \
+			--build-path "$output" "$SKETCH" > "$output/compile.log" 2>&1; then
+			printf "%-36s compile failed, see below\n" "$name"
+			cat "$output/compile.log"
+			echo "fail" >> "$BUILD_DIR/failed"
+			continue
+		fi
+
+		# Berkeley format:  text data bss dec hex filename.
+		set -- $("$size" "$output/Footprint.ino.elf" | tail -n 1)
+		text=$1
+		data=$2
+		bss=$3
+		flash=$((text + data))
+		ram=$((data + bss))
+
+		status="-"
+		set -- $(budget "$board" "$name")
+		if [ $# -eq 2 ]; then
+			status="ok"
+			if [ $flash -gt $1 ] || [ $ram -gt $2 ]; then
+				status="OVER ($1/$2)"
+				echo "fail" >> "$BUILD_DIR/failed"
+			fi
+		fi
+
+		printf "%-36s %8d %8d %8d %8d %8d  %s\n" "$name" $text $data $bss $flash $ram "$status"
+	done
+done
+
+if [ -f "$BUILD_DIR/failed" ]; then
+	echo ""
+	echo "Footprint check failed."
+	exit 1
+fi
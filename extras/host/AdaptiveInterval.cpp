@@ -0,0 +1,239 @@
+/*
+	Benchmark of the update interval.
+
+	Replays battery traces through a BatteryMeterPins with fixed update intervals and with the adaptive update
+	interval.  For each, it reports the number of ADC conversions and how long it took the meter to show a change
+	in the battery level (the level of the trace without noise).  A level change the meter never showed before the
+	next change is counted as missed.  It also reports how many times the level shown changed and how many of those
+	moved away from the level of the trace (flicker).
+
+	The "reported" trace is the load sag with the application reporting the load with setLoaded.  A meter that reads
+	often enough to pair readings on either side of the load change corrects the sag away, which shows as missed.
+*/
+
+#include <stdio.h>
+#include "BatteryMeterPins.h"
+#include "MomentaryButton.h"
+
+namespace
+{
+	const unsigned int	batteryMin		= 550;
+	const unsigned int	batteryMax		= 950;
+	const Battery::LEVEL	level		= Battery::LEVEL5;
+	const uint8_t		sensePin		= A0;
+
+	// The simulation step and the length of each trace.
+	const uint32_t		stepTime		= 100;
+	const uint32_t		traceTime		= 6UL * 3600 * 1000;
+
+	// A trace is the battery reading, without noise, at a time (in milliseconds).
+	typedef float (*Trace)(uint32_t time);
+
+	float rest(uint32_t)
+	{
+		return 900;
+	}
+
+	float discharge(uint32_t time)
+	{
+		return 940 - 380.0f * time / traceTime;
+	}
+
+	// A motor load every 30 minutes that lasts 5 minutes.  Offset so it doesn't line up with the fixed intervals.
+	bool motorOn(uint32_t time)
+	{
+		return ((time + 7300) % 1800000) >= 1500000;
+	}
+
+	float loadSag(uint32_t time)
+	{
+		return motorOn(time) ? 730 : 880;
+	}
+
+	// The battery collapses over a minute, starting a little after an hour.
+	float collapse(uint32_t time)
+	{
+		if (time < 3607300)
+		{
+			return 880;
+		}
+		if (time < 3667300)
+		{
+			return 880 - 300.0f * (time - 3607300) / 60000;
+		}
+		return 580;
+	}
+
+	// Whether the application knows there is a load at a time (in milliseconds).
+	typedef bool (*Load)(uint32_t time);
+
+	struct TraceInfo
+	{
+		const char*	name;
+		Trace		trace;
+
+		// NULL when the load isn't reported.
+		Load		load;
+	};
+
+	const TraceInfo traces[] =
+	{
+		{ "rest",		rest,		NULL },
+		{ "discharge",	discharge,	NULL },
+		{ "load sag",	loadSag,	NULL },
+		{ "reported",	loadSag,	motorOn },
+		{ "collapse",	collapse,	NULL }
+	};
+
+	struct Scheduler
+	{
+		const char*	name;
+
+		// Fixed interval when max is zero.
+		uint32_t	interval;
+		uint32_t	maxInterval;
+	};
+
+	const Scheduler schedulers[] =
+	{
+		{ "fixed 120 s",		120000,	0 },
+		{ "fixed 30 s",			30000,	0 },
+		{ "fixed 5 s",			5000,	0 },
+		{ "fixed 1 s",			1000,	0 },
+		{ "adaptive 1-120 s",	1000,	120000 }
+	};
+
+	// Deterministic noise of +/-2 counts, new each second.
+	int noise(uint32_t time)
+	{
+		uint32_t x = time / 1000 * 2654435761u;
+		return (int)((x >> 16) % 5) - 2;
+	}
+
+	Battery::LEVEL trueLevel(float reading)
+	{
+		float width	= ((float)batteryMax - batteryMin) / level;
+		int result	= (int)((reading - batteryMin) / width) + 1;
+		if (result < 1)
+		{
+			result = 1;
+		}
+		if (result > level)
+		{
+			result = level;
+		}
+		return (Battery::LEVEL)result;
+	}
+
+	void run(const TraceInfo& traceInfo, const Scheduler& scheduler)
+	{
+		Host::reset();
+
+		unsigned int lightPins[] = {2, 3, 4, 5, 6};
+		MomentaryButton button(7);
+		BatteryMeterPins meter(batteryMin, batteryMax, level);
+		meter.setSensingPin(sensePin);
+		meter.setLightPins(lightPins, HIGH);
+		meter.setActivationButton(button);
+		if (scheduler.maxInterval)
+		{
+			meter.setAdaptiveUpdateInterval(scheduler.interval, scheduler.maxInterval);
+		}
+		else
+		{
+			meter.setUpdateInterval(scheduler.interval);
+		}
+
+		button.press();
+		Host::setAnalog(sensePin, traceInfo.trace(0) + noise(0));
+		meter.begin();
+
+		Battery::LEVEL expected	= trueLevel(traceInfo.trace(0));
+		Battery::LEVEL shown	= Battery::LEVEL0;
+		unsigned long shownChanges	= 0;
+		unsigned long flicker	= 0;
+		bool pending			= false;
+		uint32_t changeTime		= 0;
+		unsigned long changes	= 0;
+		unsigned long missed	= 0;
+		double totalLatency		= 0;
+		uint32_t maxLatency		= 0;
+
+		for (uint32_t time = 0; time < traceTime; time += stepTime)
+		{
+			Host::setMillis(time);
+
+			if (traceInfo.load)
+			{
+				meter.setLoaded(traceInfo.load(time));
+			}
+
+			float reading = traceInfo.trace(time);
+			Host::setAnalog(sensePin, (int)(reading + 0.5f) + noise(time));
+			meter.update();
+
+			Battery::LEVEL level = trueLevel(reading);
+			if (level != expected)
+			{
+				if (pending)
+				{
+					missed++;
+				}
+				expected	= level;
+				pending		= true;
+				changeTime	= time;
+				changes++;
+			}
+
+			BatteryMeterSnapshot snapshot;
+			meter.getSnapshot(snapshot);
+			if (snapshot.level != shown)
+			{
+				// The first level shown isn't a change.
+				if (shown != Battery::LEVEL0)
+				{
+					shownChanges++;
+					if (abs(snapshot.level - expected) > abs(shown - expected))
+					{
+						flicker++;
+					}
+				}
+				shown = snapshot.level;
+			}
+
+			if (pending && snapshot.level == expected)
+			{
+				uint32_t latency = time - changeTime;
+				totalLatency += latency;
+				if (latency > maxLatency)
+				{
+					maxLatency = latency;
+				}
+				pending = false;
+			}
+		}
+
+		if (pending)
+		{
+			missed++;
+		}
+
+		unsigned long detected = changes - missed;
+		printf("%-10s %-18s %12lu %8lu %8lu %12.1f %12.1f %8lu %8lu\n", traceInfo.name, scheduler.name, Host::getAnalogReads(), changes, missed,
+			detected ? totalLatency / detected / 1000 : 0.0, maxLatency / 1000.0, shownChanges, flicker);
+	}
+}
+
+int main()
+{
+	printf("%-10s %-18s %12s %8s %8s %12s %12s %8s %8s\n", "Trace", "Interval", "Conversions", "Changes", "Missed", "Mean lat s", "Max lat s",
+		"Shown", "Flicker");
+	for (size_t trace = 0; trace < sizeof(traces) / sizeof(traces[0]); trace++)
+	{
+		for (size_t scheduler = 0; scheduler < sizeof(schedulers) / sizeof(schedulers[0]); scheduler++)
+		{
+			run(traces[trace], schedulers[scheduler]);
+		}
+	}
+	return 0;
+}
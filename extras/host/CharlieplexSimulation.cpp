@@ -0,0 +1,164 @@
+/*
+	Simulation of the Charlieplexed output.
+
+	For 2 to 5 pins and every level, refreshes the display many times and checks, after each refresh, which lights
+	the pins would turn on.  A light is on when its anode pin is an output driven high and its cathode pin is an
+	output driven low.  Checks that the lights for the level are each on for 1/n of the refreshes, that no other
+	light ever turns on, and reports the pin operations per refresh and the longest refresh period that still
+	refreshes the whole display 60 times a second.  Also checks that fewer than two pins are ignored and that
+	changing the pins lets go of the old ones.  Fails if any check fails.
+*/
+
+#include <stdio.h>
+#include "BatteryMeterCharlieplex.h"
+#include "MomentaryButton.h"
+
+namespace
+{
+	const unsigned int	batteryMin		= 500;
+	const unsigned int	batteryMax		= 900;
+	const uint8_t		sensePin		= A0;
+	const int			frames			= 100;
+	const float			flickerFree		= 60;
+
+	// The light (1 based) between two pins, numbered as in BatteryMeterCharlieplex.h.
+	int lightNumber(int anode, int cathode, int numberOfPins)
+	{
+		return anode * (numberOfPins - 1) + (cathode < anode ? cathode : cathode - 1) + 1;
+	}
+
+	// Simulates one level.  Returns the number of failed checks.
+	int simulate(int numberOfPins, int level, unsigned long& maxPinOperations)
+	{
+		Host::reset();
+
+		int lights				= numberOfPins * (numberOfPins - 1);
+		Battery::LEVEL maxLevel	= (Battery::LEVEL)(lights < 10 ? lights : 10);
+
+		unsigned int pins[]		= {2, 3, 4, 5, 6};
+		MomentaryButton button(7);
+		BatteryMeterCharlieplex meter(batteryMin, batteryMax, maxLevel);
+		meter.setSensingPin(sensePin);
+		meter.setCharlieplexPins(pins, numberOfPins);
+		meter.setActivationButton(button);
+		meter.setRefreshInUpdate(false);
+
+		// Set the reading to the middle of the level.  Level zero is the meter turned off.
+		float width = ((float)batteryMax - batteryMin) / maxLevel;
+		Host::setAnalog(sensePin, batteryMin + (level > 0 ? level - 0.5f : 0.5f) * width);
+		button.press();
+		meter.begin();
+		if (level == 0)
+		{
+			button.release();
+			meter.update();
+		}
+
+		int onCount[20] = {0};
+		int refreshes	= frames * numberOfPins;
+		for (int i = 0; i < refreshes; i++)
+		{
+			unsigned long before = Host::getPinWrites();
+			meter.refresh();
+			unsigned long pinOperations = Host::getPinWrites() - before;
+			if (pinOperations > maxPinOperations)
+			{
+				maxPinOperations = pinOperations;
+			}
+
+			for (int anode = 0; anode < numberOfPins; anode++)
+			{
+				for (int cathode = 0; cathode < numberOfPins; cathode++)
+				{
+					if (anode != cathode &&
+						Host::getPinMode(pins[anode]) == OUTPUT && Host::getPinLevel(pins[anode]) == HIGH &&
+						Host::getPinMode(pins[cathode]) == OUTPUT && Host::getPinLevel(pins[cathode]) == LOW)
+					{
+						onCount[lightNumber(anode, cathode, numberOfPins) - 1]++;
+					}
+				}
+			}
+		}
+
+		int failures = 0;
+		for (int light = 1; light <= lights; light++)
+		{
+			// Each light that is on should be lit for one refresh out of every n.
+			int expected = light <= level ? frames : 0;
+			if (onCount[light - 1] != expected)
+			{
+				printf("  %d pins, level %d: light %d on for %d of %d refreshes, expected %d\n",
+					numberOfPins, level, light, onCount[light - 1], refreshes, expected);
+				failures++;
+			}
+		}
+		return failures;
+	}
+}
+
+int main()
+{
+	int failures = 0;
+
+	printf("%6s %8s %8s %10s %16s %18s\n", "Pins", "Lights", "Levels", "Duty", "Pin ops/refresh", "Max period (us)");
+	for (int numberOfPins = 2; numberOfPins <= 5; numberOfPins++)
+	{
+		int lights				= numberOfPins * (numberOfPins - 1);
+		int levels				= lights < 10 ? lights : 10;
+		unsigned long pinOps	= 0;
+
+		for (int level = 0; level <= levels; level++)
+		{
+			failures += simulate(numberOfPins, level, pinOps);
+		}
+
+		// The whole display is refreshed every n calls.
+		float maxPeriod = 1000000.0f / (flickerFree * numberOfPins);
+		printf("%6d %8d %8d %9.1f%% %16lu %18.0f\n", numberOfPins, lights, levels, 100.0f / numberOfPins, pinOps, maxPeriod);
+	}
+
+	// Fewer than two pins can't light anything, the meter should leave the pins alone.
+	for (int numberOfPins = 0; numberOfPins < 2; numberOfPins++)
+	{
+		Host::reset();
+		unsigned int pins[] = {2};
+		BatteryMeterCharlieplex meter(batteryMin, batteryMax, Battery::LEVEL2);
+		meter.setCharlieplexPins(pins, numberOfPins);
+		meter.refresh();
+		if (Host::getPinWrites() != 0)
+		{
+			printf("  %d pins: pins were written\n", numberOfPins);
+			failures++;
+		}
+	}
+
+	// Setting fewer than two pins after a working setup must turn off the row that was lit.
+	{
+		Host::reset();
+		unsigned int pins[] = {2, 3, 4};
+		MomentaryButton button(7);
+		BatteryMeterCharlieplex meter(batteryMin, batteryMax, Battery::LEVEL5);
+		meter.setSensingPin(sensePin);
+		meter.setCharlieplexPins(pins, 3);
+		meter.setActivationButton(button);
+		meter.setRefreshInUpdate(false);
+		Host::setAnalog(sensePin, batteryMax);
+		button.press();
+		meter.begin();
+		meter.refresh();
+
+		meter.setCharlieplexPins(pins, 1);
+		meter.refresh();
+		for (int pin = 0; pin < 3; pin++)
+		{
+			if (Host::getPinMode(pins[pin]) != INPUT)
+			{
+				printf("  Pin %u still driven after the pins were removed\n", pins[pin]);
+				failures++;
+			}
+		}
+	}
+
+	printf("Failed checks: %d\n", failures);
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,280 @@
+/*
+	Test of the display effects.
+
+	Runs a BatteryMeterPins on the simulated clock and checks the lights after each update:
+		Transitions	The lights move one level at a time toward the level read, no faster than one level per
+					transition time, going up, going down, and turning off when the button is released.
+		Blinking	At or below the low level, the lights are on for one blink time and off for the next.  Above
+					it, they don't blink.
+		Charging	The lights above the level turn on one at a time and wrap back to the level after the top.
+		Brightness	The lights are on for brightness/256 of the PWM period, always on at 255 and always off at 0.
+	Fails if any check fails.
+*/
+
+#include <stdio.h>
+#include "BatteryMeterPins.h"
+#include "MomentaryButton.h"
+
+namespace
+{
+	const unsigned int		batteryMin		= 500;
+	const unsigned int		batteryMax		= 900;
+	const Battery::LEVEL	level			= Battery::LEVEL5;
+	const uint8_t			sensePin		= A0;
+	const uint16_t			transitionTime	= 100;
+
+	struct Display
+	{
+		unsigned int		pins[level];
+		MomentaryButton		button;
+		BatteryMeterPins	meter;
+
+		Display() :
+			button(7),
+			meter(batteryMin, batteryMax, level)
+		{
+			for (int light = 0; light < level; light++)
+			{
+				pins[light] = 2 + light;
+			}
+
+			meter.setSensingPin(sensePin);
+			meter.setLightPins(pins, HIGH);
+			meter.setActivationButton(button);
+
+			// The tests take the readings with updateNow.
+			meter.setUpdateInterval(3600000);
+		}
+
+		// Sets the reading to the middle of a level.
+		void setLevel(int shown)
+		{
+			float width = ((float)batteryMax - batteryMin) / level;
+			Host::setAnalog(sensePin, batteryMin + (shown - 0.5f) * width);
+		}
+
+		void start(int shown)
+		{
+			setLevel(shown);
+			button.press();
+			meter.begin();
+		}
+
+		// The number of lights on.  Returns -1 if the lights on aren't the bottom ones.
+		int lit()
+		{
+			int count = 0;
+			for (int light = 0; light < level; light++)
+			{
+				if (Host::getPinMode(pins[light]) == OUTPUT && Host::getPinLevel(pins[light]) == HIGH)
+				{
+					if (count != light)
+					{
+						return -1;
+					}
+					count++;
+				}
+			}
+			return count;
+		}
+	};
+
+	// Updates every millisecond until "endTime" and checks the lights step one level at a time toward "target,"
+	// at most one level per transition time, and get there in time.  Returns the number of failed checks.
+	int checkTransition(const char* name, Display& display, uint32_t startTime, uint32_t endTime, int target)
+	{
+		int failures		= 0;
+		int shown			= display.lit();
+		int steps			= target > shown ? target - shown : shown - target;
+		uint32_t lastStep	= 0;
+		bool stepped		= false;
+
+		for (uint32_t time = startTime; time <= endTime; time++)
+		{
+			Host::setMillis(time);
+			display.meter.update();
+
+			int now = display.lit();
+			if (now == shown)
+			{
+				continue;
+			}
+
+			if (now != (target > shown ? shown + 1 : shown - 1))
+			{
+				printf("  %s: went from %d to %d lights at %u ms, the target is %d\n", name, shown, now, time, target);
+				failures++;
+			}
+			if (stepped && time - lastStep < transitionTime)
+			{
+				printf("  %s: stepped after %u ms, the transition time is %u ms\n", name, time - lastStep, transitionTime);
+				failures++;
+			}
+			shown		= now;
+			lastStep	= time;
+			stepped		= true;
+		}
+
+		if (shown != target)
+		{
+			printf("  %s: %d lights at the end, expected %d\n", name, shown, target);
+			failures++;
+		}
+		else if (steps && lastStep > startTime + steps * transitionTime)
+		{
+			printf("  %s: reached the target at %u ms, expected by %u ms\n", name, lastStep, startTime + steps * transitionTime);
+			failures++;
+		}
+		return failures;
+	}
+
+	int testTransitions()
+	{
+		Host::reset();
+		Display display;
+		display.meter.setTransitionTime(transitionTime);
+
+		int failures = 0;
+		display.start(2);
+		failures += checkTransition("Turning on", display, 0, 1000, 2);
+
+		display.setLevel(5);
+		display.meter.updateNow();
+		failures += checkTransition("Going up", display, 1000, 2000, 5);
+
+		display.setLevel(1);
+		display.meter.updateNow();
+		failures += checkTransition("Going down", display, 2000, 3000, 1);
+
+		display.button.release();
+		failures += checkTransition("Turning off", display, 3000, 4000, 0);
+		return failures;
+	}
+
+	int testBlinking()
+	{
+		const uint16_t blinkTime	= 500;
+		int failures				= 0;
+
+		for (int shown = 1; shown <= 3; shown++)
+		{
+			Host::reset();
+			Display display;
+			display.meter.setLowBatteryBlink(Battery::LEVEL2, blinkTime);
+			display.start(shown);
+
+			for (uint32_t time = 0; time <= 3000; time += 10)
+			{
+				Host::setMillis(time);
+				display.meter.update();
+
+				int expected = shown <= 2 && (time / blinkTime) % 2 ? 0 : shown;
+				if (display.lit() != expected)
+				{
+					printf("  Blinking at level %d: %d lights at %u ms, expected %d\n", shown, display.lit(), time, expected);
+					failures++;
+					break;
+				}
+			}
+		}
+		return failures;
+	}
+
+	int testCharging()
+	{
+		const uint16_t sweepTime	= 250;
+		const int shown				= 3;
+		int failures				= 0;
+		bool wrapped				= false;
+		int previous				= shown;
+
+		Host::reset();
+		Display display;
+		display.meter.setCharging(true, sweepTime);
+		display.start(shown);
+
+		for (uint32_t time = 0; time <= 3000; time += 10)
+		{
+			Host::setMillis(time);
+			display.meter.update();
+
+			int expected = shown + (time / sweepTime) % (level - shown + 1);
+			if (display.lit() != expected)
+			{
+				printf("  Charging: %d lights at %u ms, expected %d\n", display.lit(), time, expected);
+				failures++;
+				break;
+			}
+
+			wrapped		= wrapped || (previous == level && display.lit() == shown);
+			previous	= display.lit();
+		}
+
+		if (!wrapped)
+		{
+			printf("  Charging: the sweep never wrapped back to the level\n");
+			failures++;
+		}
+		return failures;
+	}
+
+	int testBrightness(uint8_t brightness)
+	{
+		Host::reset();
+		Display display;
+		display.meter.setBrightness(brightness);
+		display.start(level);
+
+		// Four PWM periods of 4096 us, sampled every 4 us.  Whole periods, so the duty is exact.
+		const uint64_t startTime	= 1000000;
+		const unsigned long samples	= 4 * 4096 / 4;
+		unsigned long on			= 0;
+		int failures				= 0;
+
+		for (unsigned long sample = 0; sample < samples; sample++)
+		{
+			Host::setMicros(startTime + sample * 4);
+			display.meter.update();
+
+			int now = display.lit();
+			if (now == level)
+			{
+				on++;
+			}
+			else if (now != 0)
+			{
+				printf("  Brightness %u: %d lights on, expected all or none\n", brightness, now);
+				return 1;
+			}
+		}
+
+		float duty		= 100.0f * on / samples;
+		float expected	= brightness == 255 ? 100 : 100.0f * brightness / 256;
+		if (fabs(duty - expected) > 0.01f)
+		{
+			printf("  Brightness %u: on %.1f%% of the time, expected %.1f%%\n", brightness, duty, expected);
+			failures++;
+		}
+		printf("%10u %9.1f%% %9.1f%%\n", brightness, expected, duty);
+		return failures;
+	}
+}
+
+int main()
+{
+	int failures = 0;
+
+	failures += testTransitions();
+	failures += testBlinking();
+	failures += testCharging();
+
+	printf("%10s %10s %10s\n", "Brightness", "Expected", "Duty");
+	const uint8_t brightnesses[] = {0, 64, 128, 200, 255};
+	for (size_t index = 0; index < sizeof(brightnesses) / sizeof(brightnesses[0]); index++)
+	{
+		failures += testBrightness(brightnesses[index]);
+	}
+
+	printf("Failed checks: %d\n", failures);
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,470 @@
+/*
+	Fleet simulator.
+
+	Runs a fleet of battery packs, each watched by a real BatteryMeterPins, from full until the pack is flat (or
+	the time limit).  Each pack has its own chemistry, capacity, internal resistance, load profile, divider error,
+	and calibration error, and feeds its meter through the read function.  The packs are shared out to the cores
+	with a work-stealing thread pool: each worker takes packs from its own queue and, when that runs out, steals
+	from the others, so packs that run for longer don't leave cores idle.
+
+	For each chemistry it reports the number of level changes the meters showed, the number of those that went up
+	while the pack was discharging (flicker), and the number of ADC conversions.  The readings have +/-2 counts of
+	noise and the meter has no hysteresis, so many of the reversals are a reading sitting on a level border.  It
+	then reports the simulated pack-hours per second of wall time and, with "--scaling", repeats the run on 1 to 2x
+	the number of cores to check the speed up.  The statistics must not change with the number of threads.
+
+	FleetSimulator [--scaling] [packs] [hours] [threads]
+
+	The defaults are 2000 packs, 24 hours, and one thread per core.
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <functional>
+#include "BatteryMeterPins.h"
+#include "MomentaryButton.h"
+
+namespace
+{
+	const Battery::LEVEL	level		= Battery::LEVEL5;
+	const uint8_t			sensePin	= A0;
+
+	// The simulation step.
+	const uint32_t			stepTime	= 1000;
+
+	// The reading a full pack gives through its divider.
+	const float				fullReading	= 900;
+
+	// Open circuit voltage from empty (0) to full (1) at each 10% of charge.
+	struct Chemistry
+	{
+		const char*	name;
+		float		emptyVoltage;
+		float		fullVoltage;
+		float		curve[11];
+	};
+
+	const Chemistry chemistries[] =
+	{
+		{ "Li-ion 1S",	3.00f,	4.20f,	{ 0, 0.30f, 0.45f, 0.55f, 0.62f, 0.68f, 0.74f, 0.80f, 0.87f, 0.93f, 1 } },
+		{ "NiMH 4S",	4.00f,	5.60f,	{ 0, 0.45f, 0.55f, 0.60f, 0.63f, 0.66f, 0.69f, 0.72f, 0.76f, 0.85f, 1 } },
+		{ "Lead acid",	5.70f,	6.40f,	{ 0, 0.10f, 0.20f, 0.30f, 0.40f, 0.50f, 0.60f, 0.70f, 0.80f, 0.90f, 1 } }
+	};
+	const size_t numberOfChemistries = sizeof(chemistries) / sizeof(chemistries[0]);
+
+	// Small deterministic generator so each pack is the same whatever thread runs it.
+	class Random
+	{
+		public:
+			Random(uint32_t seed) : _state(seed * 2654435761u + 0x9E3779B9u)	{ next(); }
+
+			uint32_t next()
+			{
+				_state ^= _state << 13;
+				_state ^= _state >> 17;
+				_state ^= _state << 5;
+				return _state;
+			}
+
+			// Uniform in [low, high).
+			float uniform(float low, float high)
+			{
+				return low + (high - low) * (next() >> 8) / 16777216.0f;
+			}
+
+		private:
+			uint32_t	_state;
+	};
+
+	struct Pack
+	{
+		// Set up by the constructor.
+		const Chemistry*	chemistry;
+		float				capacity;			// mAh.
+		float				resistance;			// Ohms.
+		float				idleCurrent;		// mA.
+		float				activeCurrent;		// mA.
+		uint32_t			activeTime;			// ms of each period the load is on.
+		uint32_t			period;				// ms.
+		uint32_t			phase;				// ms.
+		float				dividerError;		// Scale on the readings.
+		bool				adaptive;			// Adaptive or fixed update interval.
+		unsigned int		lightPins[level];
+		Random				random;
+		MomentaryButton		button;
+		BatteryMeterPins	meter;
+
+		// Updated by the simulation.
+		float				charge;				// 0 to 1.
+		float				current;			// mA.
+
+		// Results.
+		uint32_t			runTime;			// ms.
+		unsigned long		levelChanges;
+		unsigned long		reversals;
+		unsigned long		conversions;
+
+		Pack(uint32_t index);
+
+		float openCircuitVoltage() const;
+		void run(uint32_t timeLimit);
+	};
+
+	// The meter is set up from the nominal range of the chemistry with an error of up to +/-2%.
+	unsigned int nominalReading(uint32_t index, bool full)
+	{
+		const Chemistry& chemistry	= chemistries[index % numberOfChemistries];
+		float reading				= full ? fullReading : chemistry.emptyVoltage / chemistry.fullVoltage * fullReading;
+		return (unsigned int)(reading * Random(full ? ~index : index ^ 0x5A5A5A5Au).uniform(0.98f, 1.02f));
+	}
+
+	unsigned int readPack(unsigned int, void* context)
+	{
+		Pack* pack = static_cast<Pack*>(context);
+		pack->conversions++;
+
+		float voltage	= pack->openCircuitVoltage() - pack->current / 1000 * pack->resistance;
+		float reading	= voltage / pack->chemistry->fullVoltage * fullReading * pack->dividerError + pack->random.uniform(-2, 2);
+		return reading < 0 ? 0 : (unsigned int)(reading + 0.5f);
+	}
+
+	Pack::Pack(uint32_t index) :
+		chemistry(&chemistries[index % numberOfChemistries]),
+		random(index),
+		button(7),
+		meter(nominalReading(index, false), nominalReading(index, true), level),
+		charge(1),
+		current(0),
+		runTime(0),
+		levelChanges(0),
+		reversals(0),
+		conversions(0)
+	{
+		capacity		= random.uniform(1500, 3500);
+		resistance		= random.uniform(0.05f, 0.30f);
+		idleCurrent		= random.uniform(20, 100);
+		activeCurrent	= random.uniform(500, 2500);
+		period			= (uint32_t)random.uniform(10, 60) * 60000;
+		activeTime		= (uint32_t)(period * random.uniform(0.05f, 0.40f));
+		phase			= random.next() % period;
+		dividerError	= random.uniform(0.99f, 1.01f);
+		adaptive		= (index / numberOfChemistries) % 2;
+
+		for (uint8_t light = 0; light < level; light++)
+		{
+			lightPins[light] = 2 + light;
+		}
+	}
+
+	float Pack::openCircuitVoltage() const
+	{
+		float position	= (charge < 0 ? 0 : charge) * 10;
+		int segment		= position >= 10 ? 9 : (int)position;
+		float fraction	= chemistry->curve[segment] + (chemistry->curve[segment+1] - chemistry->curve[segment]) * (position - segment);
+		return chemistry->emptyVoltage + (chemistry->fullVoltage - chemistry->emptyVoltage) * fraction;
+	}
+
+	// Runs the pack from full until it is flat or the time limit.  The clock is this thread's simulated board, so
+	// it is set each step for this pack.
+	void Pack::run(uint32_t timeLimit)
+	{
+		Host::setMillis(0);
+
+		meter.setSensingPin(sensePin);
+		meter.setLightPins(lightPins, HIGH);
+		meter.setActivationButton(button);
+		meter.setReadFunction(readPack, this);
+		if (adaptive)
+		{
+			meter.setAdaptiveUpdateInterval(1000, 120000);
+		}
+		else
+		{
+			meter.setUpdateInterval(30000);
+		}
+
+		button.press();
+		meter.begin();
+
+		BatteryMeterSnapshot snapshot;
+		meter.getSnapshot(snapshot);
+		Battery::LEVEL shown = snapshot.level;
+
+		uint32_t time = 0;
+		for (; time < timeLimit && charge > 0; time += stepTime)
+		{
+			Host::setMillis(time);
+
+			// Report the load as it changes with a reading on either side, as a real device would.
+			float load = (time + phase) % period < activeTime ? activeCurrent : idleCurrent;
+			if (load != current)
+			{
+				meter.updateNow();
+				current = load;
+				meter.setLoadCurrent((unsigned int)current);
+				meter.updateNow();
+			}
+			else
+			{
+				meter.update();
+			}
+
+			charge -= current * stepTime / 3600000 / capacity;
+
+			meter.getSnapshot(snapshot);
+			if (snapshot.level != shown)
+			{
+				levelChanges++;
+				if (snapshot.level > shown)
+				{
+					reversals++;
+				}
+				shown = snapshot.level;
+			}
+		}
+
+		runTime = time;
+	}
+
+	// Runs tasks on a number of threads.  Each worker has its own queue and takes tasks from the back of it.  When it
+	// is empty, the worker steals from the front of the other queues.  The tasks don't add more tasks, so a worker is
+	// done when it finds every queue empty.
+	class WorkStealingPool
+	{
+		public:
+			typedef std::function<void()> Task;
+
+			WorkStealingPool(unsigned int threads) : _queues(threads), _next(0), _steals(0)	{ }
+
+			// Deals the tasks out to the queues in turn.
+			void add(const Task& task)
+			{
+				_queues[_next++ % _queues.size()].tasks.push_back(task);
+			}
+
+			void run()
+			{
+				std::vector<std::thread> workers;
+				for (unsigned int worker = 1; worker < _queues.size(); worker++)
+				{
+					workers.push_back(std::thread(&WorkStealingPool::work, this, worker));
+				}
+				work(0);
+				for (size_t worker = 0; worker < workers.size(); worker++)
+				{
+					workers[worker].join();
+				}
+			}
+
+			unsigned long getSteals() const											{ return _steals; }
+
+		private:
+			struct Queue
+			{
+				std::mutex			mutex;
+				std::deque<Task>	tasks;
+			};
+
+			void work(unsigned int worker)
+			{
+				Host::reset();
+
+				unsigned long steals = 0;
+				Task task;
+				while (take(worker, task, steals))
+				{
+					task();
+				}
+
+				std::lock_guard<std::mutex> lock(_stealsMutex);
+				_steals += steals;
+			}
+
+			bool take(unsigned int worker, Task& task, unsigned long& steals)
+			{
+				{
+					Queue& own = _queues[worker];
+					std::lock_guard<std::mutex> lock(own.mutex);
+					if (!own.tasks.empty())
+					{
+						task = own.tasks.back();
+						own.tasks.pop_back();
+						return true;
+					}
+				}
+
+				for (size_t offset = 1; offset < _queues.size(); offset++)
+				{
+					Queue& victim = _queues[(worker + offset) % _queues.size()];
+					std::lock_guard<std::mutex> lock(victim.mutex);
+					if (!victim.tasks.empty())
+					{
+						task = victim.tasks.front();
+						victim.tasks.pop_front();
+						steals++;
+						return true;
+					}
+				}
+				return false;
+			}
+
+			std::vector<Queue>	_queues;
+			size_t				_next;
+			std::mutex			_stealsMutex;
+			unsigned long		_steals;
+	};
+
+	struct Totals
+	{
+		unsigned long	packs;
+		double			hours;
+		unsigned long	levelChanges;
+		unsigned long	reversals;
+		unsigned long	conversions;
+	};
+
+	struct Result
+	{
+		Totals			chemistry[numberOfChemistries];
+		Totals			fleet;
+		double			wallTime;
+		unsigned long	steals;
+	};
+
+	void add(Totals& totals, const Pack& pack)
+	{
+		totals.packs++;
+		totals.hours		+= pack.runTime / 3600000.0;
+		totals.levelChanges	+= pack.levelChanges;
+		totals.reversals	+= pack.reversals;
+		totals.conversions	+= pack.conversions;
+	}
+
+	// Packs are run in groups, small enough that stealing can balance the load.
+	const uint32_t groupSize = 8;
+
+	void runGroup(std::vector<Pack*>* packs, uint32_t first, uint32_t timeLimit)
+	{
+		for (uint32_t index = first; index < first + groupSize && index < packs->size(); index++)
+		{
+			(*packs)[index]->run(timeLimit);
+		}
+	}
+
+	Result simulate(uint32_t numberOfPacks, uint32_t hours, unsigned int threads)
+	{
+		// The meters are constructed up front, as they would be on each board, and run by whichever thread takes them.
+		std::vector<Pack*> packs;
+		for (uint32_t index = 0; index < numberOfPacks; index++)
+		{
+			packs.push_back(new Pack(index));
+		}
+
+		WorkStealingPool pool(threads);
+		for (uint32_t first = 0; first < numberOfPacks; first += groupSize)
+		{
+			pool.add(std::bind(runGroup, &packs, first, hours * 3600000));
+		}
+
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		pool.run();
+		std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+		Result result;
+		memset(&result.chemistry, 0, sizeof(result.chemistry));
+		memset(&result.fleet, 0, sizeof(result.fleet));
+		for (uint32_t index = 0; index < numberOfPacks; index++)
+		{
+			add(result.chemistry[index % numberOfChemistries], *packs[index]);
+			add(result.fleet, *packs[index]);
+			delete packs[index];
+		}
+		result.wallTime	= elapsed.count();
+		result.steals	= pool.getSteals();
+		return result;
+	}
+
+	void printTotals(const char* name, const Totals& totals)
+	{
+		printf("%-10s %8lu %12.1f %14lu %12.3f %16.1f\n", name, totals.packs, totals.hours, totals.levelChanges,
+			totals.packs ? (double)totals.reversals / totals.packs : 0.0, totals.packs ? (double)totals.conversions / totals.packs : 0.0);
+	}
+
+	bool sameStatistics(const Totals& a, const Totals& b)
+	{
+		return a.packs == b.packs && a.levelChanges == b.levelChanges && a.reversals == b.reversals && a.conversions == b.conversions;
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	bool scaling = argc > 1 && strcmp(argv[1], "--scaling") == 0;
+	if (scaling)
+	{
+		argc--;
+		argv++;
+	}
+
+	unsigned int cores		= std::thread::hardware_concurrency();
+	cores					= cores ? cores : 1;
+	uint32_t numberOfPacks	= argc > 1 ? atoi(argv[1]) : 2000;
+	uint32_t hours			= argc > 2 ? atoi(argv[2]) : 24;
+	unsigned int threads	= argc > 3 ? atoi(argv[3]) : cores;
+	if (numberOfPacks == 0 || hours == 0 || threads == 0)
+	{
+		printf("Usage: FleetSimulator [--scaling] [packs] [hours] [threads]\n");
+		return 1;
+	}
+
+	Result result = simulate(numberOfPacks, hours, threads);
+
+	printf("%-10s %8s %12s %14s %12s %16s\n", "Chemistry", "Packs", "Pack-hours", "Level changes", "Reversals", "Conversions");
+	for (size_t chemistry = 0; chemistry < numberOfChemistries; chemistry++)
+	{
+		printTotals(chemistries[chemistry].name, result.chemistry[chemistry]);
+	}
+	printTotals("Fleet", result.fleet);
+	printf("(Reversals and conversions are per pack.)\n\n");
+	printf("%u threads on %u cores, %lu steals: %.1f pack-hours in %.2f s = %.0f pack-hours/s\n", threads, cores, result.steals,
+		result.fleet.hours, result.wallTime, result.fleet.hours / result.wallTime);
+
+	if (!scaling)
+	{
+		return 0;
+	}
+
+	// Near linear scaling is expected up to the number of cores, and no more past it.
+	printf("\n%8s %10s %16s %10s %12s\n", "Threads", "Wall s", "Pack-hours/s", "Speed up", "Efficiency");
+	std::vector<unsigned int> counts;
+	for (unsigned int count = 1; count < cores; count *= 2)
+	{
+		counts.push_back(count);
+	}
+	counts.push_back(cores);
+	counts.push_back(2 * cores);
+
+	double baseline	= 0;
+	bool same		= true;
+	for (size_t index = 0; index < counts.size(); index++)
+	{
+		unsigned int count	= counts[index];
+		Result run			= simulate(numberOfPacks, hours, count);
+		same = same && sameStatistics(run.fleet, result.fleet);
+
+		double rate = run.fleet.hours / run.wallTime;
+		baseline = baseline ? baseline : rate;
+		printf("%8u %10.2f %16.0f %10.2f %11.0f%%\n", count, run.wallTime, rate, rate / baseline, 100 * rate / baseline / (count < cores ? count : cores));
+	}
+
+	if (!same)
+	{
+		printf("The statistics changed with the number of threads.\n");
+		return 1;
+	}
+	return 0;
+}
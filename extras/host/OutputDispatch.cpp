@@ -0,0 +1,73 @@
+/*
+	Benchmark of the output dispatch.
+
+	Compares BatteryMeterPins, where BatteryMeterWithStaticOutput calls setLights directly (curiously recurring
+	template pattern), with BatteryMeterPinsVirtual, the same output on BatteryMeterWithOutput, which calls it
+	through a virtual function.  Reports the
+	size of each meter and the time per metering, with the reading alternating so every metering changes the lights.
+	The meters are passed to the timing loops by reference through functions that are not inlined, so the compiler
+	can't see the type of the virtual meter and has to make the virtual call.
+
+	Times are for this computer, not an Arduino.  On the Arduino, use extras/footprint for the flash and RAM sizes.
+*/
+
+#include <stdio.h>
+#include <chrono>
+#include "BatteryMeterPins.h"
+#include "BatteryMeterPinsVirtual.h"
+#include "MomentaryButton.h"
+
+namespace
+{
+	const long		iterations		= 2000000;
+	const uint8_t	sensePin		= A0;
+
+	template <class meterClass>
+	void setUp(meterClass& meter, SimpleButton& button)
+	{
+		unsigned int lightPins[] = {2, 3, 4, 5, 6};
+		meter.setSensingPin(sensePin);
+		meter.setLightPins(lightPins, HIGH);
+		meter.setActivationButton(button);
+		meter.begin();
+	}
+
+	template <class meterClass>
+	__attribute__((noinline)) double timeMetering(meterClass& meter)
+	{
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		for (long i = 0; i < iterations; i++)
+		{
+			// Swap between level 2 and level 4.
+			Host::setAnalog(sensePin, (i & 1) ? 650 : 850);
+			meter.updateNow();
+		}
+		std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+		return elapsed.count() / iterations;
+	}
+}
+
+int main()
+{
+	Host::reset();
+
+	MomentaryButton button(7);
+	BatteryMeterPins crtpMeter(550, 950, Battery::LEVEL5);
+	BatteryMeterPinsVirtual virtualMeter(550, 950, Battery::LEVEL5);
+	setUp(crtpMeter, button);
+	setUp(virtualMeter, button);
+
+	// Alternate the runs so neither gets an advantage from warming up.
+	double crtpTime		= 0;
+	double virtualTime	= 0;
+	for (int run = 0; run < 3; run++)
+	{
+		crtpTime		+= timeMetering(crtpMeter);
+		virtualTime		+= timeMetering<BatteryMeterWithOutput>(virtualMeter);
+	}
+
+	printf("%-26s %10s %16s\n", "Design", "Size (B)", "Metering (ns)");
+	printf("%-26s %10u %16.1f\n", "Template (BatteryMeterPins)", (unsigned int)sizeof(crtpMeter), crtpTime / 3);
+	printf("%-26s %10u %16.1f\n", "Virtual", (unsigned int)sizeof(virtualMeter), virtualTime / 3);
+	return 0;
+}
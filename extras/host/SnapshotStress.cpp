@@ -0,0 +1,92 @@
+/*
+	Stress test of the meter snapshot.
+
+	One thread updates the snapshot as fast as it can while several threads read it.  Each reading is tied to the
+	time it was taken, so a reader can tell if the fields of a copy came from different updates.  Fails if any copy
+	is inconsistent.
+*/
+
+#include <stdio.h>
+#include <atomic>
+#include <thread>
+#include "BatteryMeter.h"
+
+namespace
+{
+	const unsigned long	updates		= 2000000;
+	const int			readers		= 3;
+	const unsigned int	batteryMax	= 1000;
+	const uint8_t		sensePin	= A0;
+
+	// What the snapshot must contain for a reading, worked out independently of the meter.
+	Battery::LEVEL expectedLevel(float reading)
+	{
+		int level = (int)(reading / (batteryMax / 10.0f)) + 1;
+		return (Battery::LEVEL)(level > 10 ? 10 : level);
+	}
+
+	unsigned int expectedPercentage(float reading)
+	{
+		return (unsigned int)(100.0 * reading / batteryMax);
+	}
+}
+
+int main()
+{
+	BatteryMeter meter(0, batteryMax, Battery::LEVEL10);
+	meter.setSensingPin(sensePin);
+	meter.begin();
+	meter.updateSnapshot();
+
+	std::atomic<bool> done(false);
+	std::atomic<unsigned long> reads(0);
+	std::atomic<unsigned long> failures(0);
+
+	std::thread writer([&]()
+	{
+		// The writer's clock is the update number, and the reading is derived from it.
+		for (unsigned long i = 1; i <= updates; i++)
+		{
+			Host::setMillis(i);
+			Host::setAnalog(sensePin, i % (batteryMax + 1));
+			meter.updateSnapshot();
+		}
+		done = true;
+	});
+
+	std::thread readerThreads[readers];
+	for (int i = 0; i < readers; i++)
+	{
+		readerThreads[i] = std::thread([&]()
+		{
+			unsigned long count = 0;
+			while (!done)
+			{
+				BatteryMeterSnapshot snapshot;
+				meter.getSnapshot(snapshot);
+				count++;
+
+				if (snapshot.reading != snapshot.time % (batteryMax + 1) ||
+					snapshot.level != expectedLevel(snapshot.reading) ||
+					snapshot.percentage != expectedPercentage(snapshot.reading))
+				{
+					if (failures++ < 10)
+					{
+						printf("Inconsistent snapshot: time %lu reading %g level %d percentage %u\n",
+							(unsigned long)snapshot.time, snapshot.reading, snapshot.level, snapshot.percentage);
+					}
+				}
+			}
+			reads += count;
+		});
+	}
+
+	writer.join();
+	for (int i = 0; i < readers; i++)
+	{
+		readerThreads[i].join();
+	}
+
+	printf("Updates: %lu    Reads: %lu    Inconsistent: %lu\n", updates, (unsigned long)reads, (unsigned long)failures);
+	return failures ? 1 : 0;
+}
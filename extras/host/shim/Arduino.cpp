@@ -0,0 +1,119 @@
+#include "Arduino.h"
+
+HostSerial Serial;
+
+namespace
+{
+	struct Board
+	{
+		uint64_t		micros;
+		uint8_t			modes[Host::numberOfPins];
+		uint8_t			levels[Host::numberOfPins];
+		int				analogValues[Host::numberOfPins];
+		unsigned long	analogReads;
+		unsigned long	pinWrites;
+	};
+
+	thread_local Board board;
+}
+
+void pinMode(uint8_t pin, uint8_t mode)
+{
+	board.modes[pin % Host::numberOfPins] = mode;
+	board.pinWrites++;
+}
+
+void digitalWrite(uint8_t pin, uint8_t value)
+{
+	board.levels[pin % Host::numberOfPins] = value ? HIGH : LOW;
+	board.pinWrites++;
+}
+
+int digitalRead(uint8_t pin)
+{
+	return board.levels[pin % Host::numberOfPins];
+}
+
+int analogRead(uint8_t pin)
+{
+	board.analogReads++;
+	return board.analogValues[pin % Host::numberOfPins];
+}
+
+void analogWrite(uint8_t pin, int value)
+{
+	digitalWrite(pin, value > 127);
+}
+
+unsigned long millis()
+{
+	return (unsigned long)(board.micros / 1000);
+}
+
+unsigned long micros()
+{
+	return (unsigned long)board.micros;
+}
+
+void delay(unsigned long ms)
+{
+	board.micros += (uint64_t)ms * 1000;
+}
+
+void delayMicroseconds(unsigned int us)
+{
+	board.micros += us;
+}
+
+namespace Host
+{
+	void reset()
+	{
+		board = Board();
+	}
+
+	void setMicros(uint64_t us)
+	{
+		board.micros = us;
+	}
+
+	void setMillis(uint64_t ms)
+	{
+		board.micros = ms * 1000;
+	}
+
+	void advanceMillis(uint32_t ms)
+	{
+		board.micros += (uint64_t)ms * 1000;
+	}
+
+	uint64_t getMicros()
+	{
+		return board.micros;
+	}
+
+	void setAnalog(uint8_t pin, int value)
+	{
+		board.analogValues[pin % numberOfPins] = value;
+	}
+
+	uint8_t getPinMode(uint8_t pin)
+	{
+		return board.modes[pin % numberOfPins];
+	}
+
+	uint8_t getPinLevel(uint8_t pin)
+	{
+		return board.levels[pin % numberOfPins];
+	}
+
+	unsigned long getAnalogReads()
+	{
+		return board.analogReads;
+	}
+
+	unsigned long getPinWrites()
+	{
+		return board.pinWrites;
+	}
+}
@@ -0,0 +1,84 @@
+/*
+	Host shim for the Arduino core.  Provides just enough of the Arduino API to build the library on a computer
+	for the simulations, benchmarks, and tests in extras/host.
+
+	The simulated hardware (clock, pins, analog values) is per thread, so each thread simulates its own board.
+	The functions in the Host namespace control it.
+*/
+
+#ifndef HOST_ARDUINO_H
+#define HOST_ARDUINO_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <math.h>
+#include <iostream>
+
+#define HIGH			0x1
+#define LOW				0x0
+
+#define INPUT			0x0
+#define OUTPUT			0x1
+#define INPUT_PULLUP	0x2
+
+#define A0				14
+#define A1				15
+#define A2				16
+#define A3				17
+#define A4				18
+#define A5				19
+
+typedef bool	boolean;
+typedef uint8_t	byte;
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t value);
+int digitalRead(uint8_t pin);
+int analogRead(uint8_t pin);
+void analogWrite(uint8_t pin, int value);
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+
+// Prints to standard out.
+class HostSerial
+{
+	public:
+		void begin(unsigned long)								{ }
+		template <class T> void print(T value)					{ std::cout << value; }
+		template <class T> void println(T value)				{ std::cout << value << "\n"; }
+		void println()											{ std::cout << "\n"; }
+};
+
+extern HostSerial Serial;
+
+namespace Host
+{
+	// The number of simulated pins.
+	const uint8_t numberOfPins = 64;
+
+	// Resets the clock, pins, and counters of this thread's board.
+	void reset();
+
+	// The simulated clock.
+	void setMicros(uint64_t us);
+	void setMillis(uint64_t ms);
+	void advanceMillis(uint32_t ms);
+	uint64_t getMicros();
+
+	// The value analogRead returns for a pin.
+	void setAnalog(uint8_t pin, int value);
+
+	// The state of a pin as set by pinMode and digitalWrite.
+	uint8_t getPinMode(uint8_t pin);
+	uint8_t getPinLevel(uint8_t pin);
+
+	// Counters of the calls made to the hardware.
+	unsigned long getAnalogReads();
+	unsigned long getPinWrites();
+}
+
+#endif
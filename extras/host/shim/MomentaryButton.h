@@ -0,0 +1,16 @@
+/*
+	Host shim for the ButtonSuite MomentaryButton.
+*/
+
+#ifndef HOST_MOMENTARYBUTTON_H
+#define HOST_MOMENTARYBUTTON_H
+
+#include "SimpleButton.h"
+
+class MomentaryButton : public SimpleButton
+{
+	public:
+		MomentaryButton(uint8_t pin) : SimpleButton(pin)				{ }
+};
+
+#endif
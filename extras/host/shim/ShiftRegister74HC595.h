@@ -0,0 +1,61 @@
+/*
+	Host shim for the ShiftRegister74HC595 library.  Keeps the output bits in memory.
+*/
+
+#ifndef HOST_SHIFTREGISTER74HC595_H
+#define HOST_SHIFTREGISTER74HC595_H
+
+#include "Arduino.h"
+
+template <uint8_t size>
+class ShiftRegister74HC595
+{
+	public:
+		ShiftRegister74HC595(uint8_t, uint8_t, uint8_t) : _updates(0)
+		{
+			for (int i = 0; i < size; i++)
+			{
+				_pending[i]	= 0;
+				_outputs[i]	= 0;
+			}
+		}
+
+		void setNoUpdate(uint8_t pin, uint8_t value)
+		{
+			if (value)
+			{
+				_pending[pin / 8] |= 1 << (pin % 8);
+			}
+			else
+			{
+				_pending[pin / 8] &= ~(1 << (pin % 8));
+			}
+		}
+
+		void set(uint8_t pin, uint8_t value)
+		{
+			setNoUpdate(pin, value);
+			updateRegisters();
+		}
+
+		void updateRegisters()
+		{
+			for (int i = 0; i < size; i++)
+			{
+				_outputs[i] = _pending[i];
+			}
+			_updates++;
+		}
+
+		uint8_t get(uint8_t pin)										{ return (_outputs[pin / 8] >> (pin % 8)) & 1; }
+
+		// Host only.
+		unsigned long getUpdates()										{ return _updates; }
+
+	private:
+		uint8_t			_pending[size];
+		uint8_t			_outputs[size];
+		unsigned long	_updates;
+};
+
+#endif
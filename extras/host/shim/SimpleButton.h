@@ -0,0 +1,48 @@
+/*
+	Host shim for the ButtonSuite SimpleButton.  The button is pressed and released by the simulation instead
+	of reading a pin.  Like the real buttons, the "WAS" states are only reported once.
+*/
+
+#ifndef HOST_SIMPLEBUTTON_H
+#define HOST_SIMPLEBUTTON_H
+
+#include "Arduino.h"
+
+enum BUTTONSTATUS
+{
+	NOTPRESSED,
+	WASPRESSED,
+	ISPRESSED,
+	WASSHORTPRESSED,
+	WASLONGPRESSED
+};
+
+class SimpleButton
+{
+	public:
+		SimpleButton(uint8_t pin) : _pin(pin), _status(NOTPRESSED)		{ }
+
+		BUTTONSTATUS getStatus()
+		{
+			BUTTONSTATUS status = _status;
+			if (status == WASPRESSED)
+			{
+				_status = ISPRESSED;
+			}
+			else if (status == WASSHORTPRESSED || status == WASLONGPRESSED)
+			{
+				_status = NOTPRESSED;
+			}
+			return status;
+		}
+
+		// Host only.
+		void press()													{ _status = WASPRESSED; }
+		void release()													{ _status = WASSHORTPRESSED; }
+
+	private:
+		uint8_t			_pin;
+		BUTTONSTATUS	_status;
+};
+
+#endif
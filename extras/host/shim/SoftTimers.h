@@ -0,0 +1,26 @@
+/*
+	Host shim for the SoftTimers library.  Only SoftTimer is provided.
+*/
+
+#ifndef HOST_SOFTTIMERS_H
+#define HOST_SOFTTIMERS_H
+
+#include "Arduino.h"
+
+class SoftTimer
+{
+	public:
+		SoftTimer() : _timeOutTime(0), _start(millis())			{ }
+
+		void setTimeOutTime(uint32_t timeOutTime)				{ _timeOutTime = timeOutTime; }
+		uint32_t getTimeOutTime() const							{ return _timeOutTime; }
+		void reset()											{ _start = millis(); }
+		bool hasTimedOut() const								{ return getElapsedTime() >= _timeOutTime; }
+		uint32_t getElapsedTime() const							{ return millis() - _start; }
+
+	private:
+		uint32_t	_timeOutTime;
+		uint32_t	_start;
+};
+
+#endif
@@ -27,8 +27,38 @@
 BatteryMeter::BatteryMeter(unsigned int batteryMin, unsigned int batteryMax, Battery::LEVEL maxLevel) :
 	_maxLevel(maxLevel),
 	_batteryMin(batteryMin),
-	_batteryMax(batteryMax)
+	_batteryMax(batteryMax),
+	_readFunction(NULL),
+	_readContext(NULL),
+	_vccCompensation(false),
+	_vccRefreshInterval(10000),
+	_bandgap(1100),
+	#if defined(__AVR__)
+		_nominalVcc(5000),
+	#else
+		_nominalVcc(3300),
+	#endif
+	_adcBits(10),
+	_vcc(0),
+	_lastVccRefresh(0),
+	_autoCalibrate(false),
+	_calibrationMaxStep(100),
+	_calibrationFilter(0),
+	_calibrationRejected(0),
+	_observedMin(0),
+	_observedMax(0),
+	_loadCurrent(0),
+	_loadChanged(false),
+	_previousReading(0),
+	_previousLoadCurrent(0),
+	_previousReadingTime(0),
+	_internalResistance(0),
+	_snapshotSequence(0)
 {
+	_snapshots[0].reading		= 0;
+	_snapshots[0].level			= Battery::LEVEL0;
+	_snapshots[0].percentage	= 0;
+	_snapshots[0].time			= 0;
 }
 
 BatteryMeter::~BatteryMeter()
@@ -46,8 +76,7 @@ void BatteryMeter::setSensingPin(unsigned int sensingPin)
 
 void BatteryMeter::begin()
 {
-	// The width of each level is in the units read from the sensing pin.
-	_levelWidth = ((float)_batteryMax - _batteryMin) / (_maxLevel);
+	updateLevelWidth();
 
 	#ifdef BATTERYMETERDEBUG
 		// We are dubugging, print info.
@@ -70,25 +99,35 @@ void BatteryMeter::begin()
 
 float BatteryMeter::readSensePin()
 {
-	float sensePinReading = analogRead(_sensingPin);
+	unsigned int sensePinReading = _readFunction ? _readFunction(_sensingPin, _readContext) : analogRead(_sensingPin);
 
 	#ifdef BATTERYMETERDEBUG
 		Serial.print("[BatteryMeter] Reading: ");
 		Serial.println(sensePinReading);
 	#endif
 
+	if (_vccCompensation)
+	{
+		sensePinReading = convertToMillivolts(sensePinReading);
+	}
+
+	sensePinReading = compensateLoad(sensePinReading);
+
+	if (_autoCalibrate)
+	{
+		trackCalibrationReading(sensePinReading);
+	}
+
 	return sensePinReading;
 }
 
 Battery::LEVEL BatteryMeter::getBatteryLevel()
 {
-	float sensePinReading = analogRead(_sensingPin);
-
-	#ifdef BATTERYMETERDEBUG
-		Serial.print("[BatteryMeter] Reading: ");
-		Serial.println(sensePinReading);
-	#endif
+	return convertReadingToLevel(readSensePin());
+}
 
+Battery::LEVEL BatteryMeter::convertReadingToLevel(float sensePinReading)
+{
 	float currentLevelMax;
 
 	for (int i = 0; i < _maxLevel; i++)
@@ -110,8 +149,11 @@ Battery::LEVEL BatteryMeter::getBatteryLevel()
 
 unsigned int BatteryMeter::getBatteryPercentage()
 {
-	float sensePinReading = analogRead(_sensingPin);
+	return convertReadingToPercentage(readSensePin());
+}
 
+unsigned int BatteryMeter::convertReadingToPercentage(float sensePinReading)
+{
 	if (sensePinReading < _batteryMin)
 	{
 		#ifdef BATTERYMETERDEBUG
@@ -138,8 +180,370 @@ unsigned int BatteryMeter::getBatteryPercentage()
 	return percentage;
 }
 
+void BatteryMeter::updateSnapshot()
+{
+	float sensePinReading = readSensePin();
+	publishSnapshot(sensePinReading, convertReadingToLevel(sensePinReading));
+}
+
+void BatteryMeter::publishSnapshot(float sensePinReading, Battery::LEVEL level)
+{
+	// Fill the copy that readers are not using.
+	uint8_t sequence					= _snapshotSequence + 1;
+	BatteryMeterSnapshot& snapshot		= _snapshots[sequence & 1];
+	snapshot.reading					= sensePinReading;
+	snapshot.level						= level;
+	snapshot.percentage					= convertReadingToPercentage(sensePinReading);
+	snapshot.time						= millis();
+
+	// Make sure the copy is written before it is made visible.  The sequence is a single byte, so switching is atomic.
+	__sync_synchronize();
+	_snapshotSequence = sequence;
+}
+
+void BatteryMeter::getSnapshot(BatteryMeterSnapshot& snapshot)
+{
+	// An interrupt can't be interrupted by the loop, so from an interrupt this never repeats.
+	uint8_t sequence;
+	do
+	{
+		sequence = _snapshotSequence;
+		__sync_synchronize();
+		snapshot = _snapshots[sequence & 1];
+		__sync_synchronize();
+	}
+	while (sequence != _snapshotSequence);
+}
+
 void BatteryMeter::setMinMaxReadingValues(unsigned int batteryMin, unsigned int batteryMax)
 {
 	_batteryMin = batteryMin;
 	_batteryMax = batteryMax;
+
+	updateLevelWidth();
+}
+
+void BatteryMeter::setReadFunction(BatteryMeterReadFunction readFunction, void* context)
+{
+	_readFunction	= readFunction;
+	_readContext	= context;
+}
+
+void BatteryMeter::setVccCompensation(bool enabled, uint32_t refreshInterval, unsigned int bandgap)
+{
+	_vccCompensation	= enabled;
+	_vccRefreshInterval	= refreshInterval;
+	_bandgap			= bandgap;
+
+	// Measure again on the next reading.
+	_vcc				= 0;
+}
+
+void BatteryMeter::setNominalVcc(unsigned int nominalVcc, uint8_t adcBits)
+{
+	// The conversion rounds with a shift of adcBits-1 and the product of the reading and Vcc must fit in 32 bits.
+	if (adcBits == 0 || adcBits > 16)
+	{
+		return;
+	}
+
+	_nominalVcc	= nominalVcc;
+	_adcBits	= adcBits;
+
+	// Measure again on the next reading.
+	_vcc		= 0;
+}
+
+void BatteryMeter::setAutoCalibration(bool enabled, unsigned int maxStep)
+{
+	_autoCalibrate			= enabled;
+	_calibrationMaxStep		= maxStep;
+
+	// Start over with a fresh filter and no observed extremes.
+	_calibrationRejected	= 0;
+	_observedMin			= 0;
+	_observedMax			= 0;
+}
+
+void BatteryMeter::signalChargeComplete()
+{
+	// Nothing has been observed since the last time, so there is nothing to learn from.
+	if (!_autoCalibrate || _observedMax == 0)
+	{
+		return;
+	}
+
+	applyCalibration(_batteryMin, stepCalibration(_batteryMax, _observedMax));
+
+	// Start looking for the next peak.
+	_observedMax = _calibrationFilter >> _calibrationFilterShift;
+}
+
+void BatteryMeter::signalBrownOut()
+{
+	if (!_autoCalibrate || _observedMax == 0)
+	{
+		return;
+	}
+
+	applyCalibration(stepCalibration(_batteryMin, _observedMin), _batteryMax);
+
+	// Start looking for the next low.
+	_observedMin = _calibrationFilter >> _calibrationFilterShift;
+}
+
+void BatteryMeter::setLoadCurrent(unsigned int loadCurrent)
+{
+	if (loadCurrent != _loadCurrent)
+	{
+		_loadCurrent	= loadCurrent;
+		_loadChanged	= true;
+	}
+}
+
+void BatteryMeter::setLoaded(bool loaded)
+{
+	// A load of one unit makes the internal resistance the voltage drop of the load.
+	setLoadCurrent(loaded ? 1 : 0);
+}
+
+bool BatteryMeter::loadChanged()
+{
+	bool changed	= _loadChanged;
+	_loadChanged	= false;
+	return changed;
+}
+
+void BatteryMeter::updateLevelWidth()
+{
+	// The width of each level is in the units read from the sensing pin.
+	_levelWidth = ((float)_batteryMax - _batteryMin) / (_maxLevel);
+}
+
+unsigned int BatteryMeter::convertToMillivolts(unsigned int reading)
+{
+	uint32_t now = millis();
+	if (_vcc == 0 || now - _lastVccRefresh >= _vccRefreshInterval)
+	{
+		_vcc			= readVcc();
+		_lastVccRefresh	= now;
+
+		#ifdef BATTERYMETERDEBUG
+			Serial.print("[BatteryMeter] Vcc (mV): ");
+			Serial.println(_vcc);
+		#endif
+	}
+
+	// Full scale of the ADC is 2^bits counts of Vcc.  Round to the nearest millivolt.
+	return ((uint32_t)reading * _vcc + ((uint32_t)1 << (_adcBits - 1))) >> _adcBits;
+}
+
+unsigned int BatteryMeter::readVcc()
+{
+	// The readings don't come from the ADC, so its supply says nothing about them.
+	if (_readFunction)
+	{
+		return _nominalVcc;
+	}
+
+	#if defined(__AVR__)
+		// The analogRead just before this left the sketch's reference in ADMUX.  The bandgap can only be measured against Vcc,
+		// and switching away from an external reference shorts AREF to AVcc, so with any other reference leave it alone.
+		#if defined(__AVR_ATtiny24__) || defined(__AVR_ATtiny44__) || defined(__AVR_ATtiny84__) || defined(__AVR_ATtiny25__) || defined(__AVR_ATtiny45__) || defined(__AVR_ATtiny85__)
+			const uint8_t vccReference = 0;
+		#else
+			const uint8_t vccReference = _BV(REFS0);
+		#endif
+		if ((ADMUX & (_BV(REFS1) | _BV(REFS0))) != vccReference)
+		{
+			return _nominalVcc;
+		}
+
+		// Measure the bandgap with Vcc as the reference.  The bandgap input differs between chips.
+		#if defined(__AVR_ATmega32U4__) || defined(__AVR_ATmega1280__) || defined(__AVR_ATmega2560__)
+			// MUX5 is in ADCSRB and is left set by an analogRead of the upper channels (A8 to A15 on the Mega).
+			ADCSRB &= ~_BV(MUX5);
+			ADMUX = _BV(REFS0) | _BV(MUX4) | _BV(MUX3) | _BV(MUX2) | _BV(MUX1);
+		#elif defined(__AVR_ATtiny24__) || defined(__AVR_ATtiny44__) || defined(__AVR_ATtiny84__)
+			ADMUX = _BV(MUX5) | _BV(MUX0);
+		#elif defined(__AVR_ATtiny25__) || defined(__AVR_ATtiny45__) || defined(__AVR_ATtiny85__)
+			ADMUX = _BV(MUX3) | _BV(MUX2);
+		#else
+			ADMUX = _BV(REFS0) | _BV(MUX3) | _BV(MUX2) | _BV(MUX1);
+		#endif
+
+		// Let the reference settle.  This only happens once per refresh interval.
+		delay(2);
+
+		ADCSRA |= _BV(ADSC);
+		while (bit_is_set(ADCSRA, ADSC))
+		{
+		}
+
+		// ADCL must be read first.  analogRead selects its own input, so nothing needs to be restored.
+		uint8_t low		= ADCL;
+		uint8_t high	= ADCH;
+		uint16_t result	= (high << 8) | low;
+
+		if (result == 0)
+		{
+			return _nominalVcc;
+		}
+
+		// bandgap = result/1024 * Vcc.
+		return ((uint32_t)_bandgap << 10) / result;
+	#else
+		return _nominalVcc;
+	#endif
+}
+
+unsigned int BatteryMeter::compensateLoad(unsigned int reading)
+{
+	uint32_t now = millis();
+
+	// Pair this reading with the last one if the load changed between them.  The higher load should have the lower reading.
+	// If it doesn't, the battery changed for some other reason (charging, for example) and the pair is skipped.
+	if (_loadCurrent != _previousLoadCurrent && _previousReading != 0 && now - _previousReadingTime <= _loadPairWindow)
+	{
+		bool loadIncreased		= _loadCurrent > _previousLoadCurrent;
+		unsigned int highLoad	= loadIncreased ? _loadCurrent : _previousLoadCurrent;
+		unsigned int lowLoad	= loadIncreased ? _previousLoadCurrent : _loadCurrent;
+		unsigned int highLoadV	= loadIncreased ? reading : _previousReading;
+		unsigned int lowLoadV	= loadIncreased ? _previousReading : reading;
+
+		if (highLoadV <= lowLoadV)
+		{
+			// R = dV/dI in fixed point.
+			uint32_t resistance = ((uint32_t)(lowLoadV - highLoadV) << _resistanceShift) / (highLoad - lowLoad);
+
+			if (_internalResistance == 0)
+			{
+				_internalResistance = resistance;
+			}
+			else
+			{
+				// Exponential moving average.
+				_internalResistance -= _internalResistance >> _resistanceFilterShift;
+				_internalResistance += resistance >> _resistanceFilterShift;
+			}
+
+			#ifdef BATTERYMETERDEBUG
+				Serial.print("[BatteryMeter] Internal resistance (fixed point): ");
+				Serial.println(_internalResistance);
+			#endif
+		}
+	}
+
+	_previousReading		= reading;
+	_previousLoadCurrent	= _loadCurrent;
+	_previousReadingTime	= now;
+
+	if (_loadCurrent == 0 || _internalResistance == 0)
+	{
+		return reading;
+	}
+
+	// Add back the drop across the internal resistance (I*R), saturating instead of overflowing.
+	uint32_t drop = _internalResistance > 0xFFFFFFFF / _loadCurrent ? 0xFFFFFFFF : _internalResistance * _loadCurrent;
+	drop >>= _resistanceShift;
+
+	if (drop > 0xFFFFu - reading)
+	{
+		return 0xFFFF;
+	}
+	return reading + drop;
+}
+
+void BatteryMeter::trackCalibrationReading(unsigned int reading)
+{
+	// The first reading seeds the filter.
+	if (_observedMax == 0)
+	{
+		_calibrationFilter		= (uint32_t)reading << _calibrationFilterShift;
+		_calibrationRejected	= 0;
+		_observedMin			= reading;
+		_observedMax			= reading;
+		return;
+	}
+
+	unsigned int filtered	= _calibrationFilter >> _calibrationFilterShift;
+	unsigned int difference	= reading > filtered ? reading - filtered : filtered - reading;
+
+	if (difference > _calibrationMaxStep)
+	{
+		// A spike, reject it.  If we keep getting them, the battery really changed, so restart the filter at the new value.
+		_calibrationRejected++;
+		if (_calibrationRejected < _calibrationMaxRejected)
+		{
+			#ifdef BATTERYMETERDEBUG
+				Serial.println("[BatteryMeter] Calibration reading rejected.");
+			#endif
+			return;
+		}
+		_calibrationFilter = (uint32_t)reading << _calibrationFilterShift;
+	}
+	else
+	{
+		// Exponential moving average:  filter += reading - filter/2^shift.
+		_calibrationFilter += reading;
+		_calibrationFilter -= filtered;
+	}
+	_calibrationRejected = 0;
+
+	filtered = _calibrationFilter >> _calibrationFilterShift;
+	if (filtered < _observedMin)
+	{
+		_observedMin = filtered;
+	}
+	if (filtered > _observedMax)
+	{
+		_observedMax = filtered;
+	}
+}
+
+unsigned int BatteryMeter::stepCalibration(unsigned int endPoint, unsigned int observed)
+{
+	unsigned int difference = observed > endPoint ? observed - endPoint : endPoint - observed;
+
+	// Move part of the way, but always at least one unit so small differences still converge.
+	unsigned int step = difference >> _calibrationStepShift;
+	if (step == 0)
+	{
+		step = difference;
+	}
+
+	// Limit the step instead of rejecting large differences.  A single bad event can only move the end point
+	// "maxStep," but a starting value that is far off still converges over several events.
+	if (step > _calibrationMaxStep)
+	{
+		#ifdef BATTERYMETERDEBUG
+			Serial.print("[BatteryMeter] Calibration step limited, observed: ");
+			Serial.println(observed);
+		#endif
+		step = _calibrationMaxStep;
+	}
+
+	return observed > endPoint ? endPoint + step : endPoint - step;
+}
+
+void BatteryMeter::applyCalibration(unsigned int batteryMin, unsigned int batteryMax)
+{
+	// The range must stay large enough that each level is at least one reading wide.
+	if (batteryMax < batteryMin + _maxLevel)
+	{
+		#ifdef BATTERYMETERDEBUG
+			Serial.println("[BatteryMeter] Calibration rejected, range too small.");
+		#endif
+		return;
+	}
+
+	// Only the level width depends on the min and max, so this is all that needs updating.
+	setMinMaxReadingValues(batteryMin, batteryMax);
+
+	#ifdef BATTERYMETERDEBUG
+		Serial.print("[BatteryMeter] Calibrated min: ");
+		Serial.print(_batteryMin);
+		Serial.print("    max: ");
+		Serial.println(_batteryMax);
+	#endif
 }
\ No newline at end of file
@@ -59,6 +59,23 @@
 #include "SimpleButton.h"
 #include "BatteryMeterEnums.h"
 
+// A function that takes a reading.  It is passed the sensing pin and the context given to setReadFunction and returns the reading.
+typedef unsigned int (*BatteryMeterReadFunction)(unsigned int sensingPin, void* context);
+
+// The state of the meter at one point in time.  See BatteryMeter::getSnapshot.
+struct BatteryMeterSnapshot
+{
+	// The sensing pin reading (after any corrections).
+	float					reading;
+
+	// The reading converted to a level and a percentage.
+	Battery::LEVEL			level;
+	unsigned int			percentage;
+
+	// When the reading was taken (millis).
+	uint32_t				time;
+};
+
 class BatteryMeter
 {
 	// Constructors and destructor.
@@ -75,13 +92,60 @@ class BatteryMeter
 		void setSensingPin(unsigned int sensingPin);
 
 		// Initialization.  Run this after the other setup functions.
-		virtual void begin();
+		void begin();
 
 	// Optional settings.
 	public:
 		// Ideally, you should use the constructor for this, but if you need to modify them on the fly you can use this.
 		void setMinMaxReadingValues(unsigned int batteryMin, unsigned int batteryMax);
 
+		// Takes readings with the function instead of analogRead.  Use this for an external ADC or to drive the meter from simulated
+		// readings (for example, when running it on a computer).  "context" is passed back to the function with each reading so it can
+		// find the state of the battery it is reading.  Pass NULL to go back to analogRead.
+		void setReadFunction(BatteryMeterReadFunction readFunction, void* context = NULL);
+
+		// Turns on automatic calibration.  The meter filters the readings and tracks the highest and lowest values it sees.  When the
+		// application signals that the battery is full (signalChargeComplete) or empty (signalBrownOut), the max or min is moved part
+		// of the way toward the observed extreme.  Repeated charge cycles converge the calibration.  The values passed to the constructor
+		// are used as the starting point.  "maxStep" (in reading units) guards against outliers.  Readings further than this from the filtered
+		// value are rejected, and a single event never moves the min or max by more than this.
+		void setAutoCalibration(bool enabled, unsigned int maxStep = 100);
+
+		// Corrects the readings for changes in the supply voltage (Vcc) and converts them to millivolts, so the min and max must then be
+		// given in millivolts.  The analog readings are relative to Vcc, so without this a drooping regulator or running from USB changes
+		// the reading for the same battery voltage.  Vcc is measured against the internal bandgap reference (AVR only, see setNominalVcc
+		// for other boards) and the result is kept for "refreshInterval" milliseconds so every reading doesn't require two conversions.
+		// "bandgap" is the reference voltage in millivolts.  It is nominally 1100, but varies between chips by up to 10%, so measure it
+		// for your board for the best accuracy.  Measuring Vcc needs the DEFAULT analog reference.  With any other analogReference (INTERNAL,
+		// or EXTERNAL with a voltage on AREF) the reference is never switched, because that would short AREF to AVcc, and the readings are
+		// converted with the nominal Vcc instead, so pass the reference voltage to setNominalVcc.
+		void setVccCompensation(bool enabled, uint32_t refreshInterval = 10000, unsigned int bandgap = 1100);
+
+		// The supply voltage in millivolts and the resolution of the readings in bits used to convert readings to millivolts.  Vcc can only
+		// be measured on AVR boards, so other boards, and meters with a read function, use "nominalVcc" as the supply voltage.  The defaults
+		// are 5000 mV on AVR boards, 3300 mV on others, and 10 bits.  If you change analogReadResolution, pass the same number of bits here.
+		// The bits must be 1 to 16, otherwise the call is ignored.
+		void setNominalVcc(unsigned int nominalVcc, uint8_t adcBits = 10);
+
+	// Calibration events.  Call these from your application when the battery reaches one of its end points.
+	public:
+		// The charger reports the battery is full.  Anchors the max reading.
+		void signalChargeComplete();
+
+		// The battery has reached the point the device can no longer run.  Anchors the min reading.
+		void signalBrownOut();
+
+	// Load compensation.  Report the load as it changes so readings taken under load can be corrected.
+	public:
+		// Reports the current drawn from the battery in any units you like (for example, mA), zero for no load.  The meter estimates the
+		// internal resistance of the battery from readings taken before and after the load changes and uses it to correct readings back to
+		// the voltage the battery would have without a load.  Only readings taken within a few seconds of each other are paired, so take a
+		// reading (readSensePin or updateNow) just before and just after changing the load.
+		void setLoadCurrent(unsigned int loadCurrent);
+
+		// Use this version when only whether the battery is under load is known.  The correction is then the average voltage drop of the load.
+		void setLoaded(bool loaded);
+
 	// Loop functions.  Run these functions in your "loop" routine as required.
 	public:
 		// Gets the reading from the sensing pin.
@@ -93,6 +157,53 @@ class BatteryMeter
 		// Returns the battery level as a percentage.
 		unsigned int getBatteryPercentage();
 
+		// Reads the battery and saves the reading, level, and percentage as a snapshot.  The meters with output do this each time they
+		// update, so this is only needed when using the BatteryMeter by itself.
+		void updateSnapshot();
+
+	// Reading the state from other contexts.
+	public:
+		// Copies the most recent snapshot.  This is safe to call from an interrupt (or another thread) while the loop is updating the meter.
+		// The copy is always consistent and interrupts are not disabled.
+		void getSnapshot(BatteryMeterSnapshot& snapshot);
+
+	// Protected functions.  Used by the derived classes.
+	protected:
+		// Saves the reading, and what it converts to, as the latest snapshot.  Only one context (normally the loop) may call this.
+		void publishSnapshot(float sensePinReading, Battery::LEVEL level);
+
+		// Converts a sensing pin reading into a percentage.
+		unsigned int convertReadingToPercentage(float sensePinReading);
+
+		// Converts a sensing pin reading into a battery level.
+		Battery::LEVEL convertReadingToLevel(float sensePinReading);
+
+		// Returns true once for each change of the load reported with setLoadCurrent or setLoaded.
+		bool loadChanged();
+
+	// Private functions.  The user need not worry about these.
+	private:
+		// Calculates the width of a level from the min and max.  This is all that has to be done when the min or max changes.
+		void updateLevelWidth();
+
+		// Converts a reading to millivolts using the supply voltage, measuring the supply voltage if it is due.
+		unsigned int convertToMillivolts(unsigned int reading);
+
+		// Measures the supply voltage, in millivolts, with the internal bandgap reference.  Returns the nominal Vcc if it can't be measured.
+		unsigned int readVcc();
+
+		// Updates the internal resistance estimate and returns the reading corrected for the load.
+		unsigned int compensateLoad(unsigned int reading);
+
+		// Adds a reading to the filter and tracks the extremes used for automatic calibration.
+		void trackCalibrationReading(unsigned int reading);
+
+		// Returns the calibration end point moved part of the way toward the observed value, but never more than the max step.
+		unsigned int stepCalibration(unsigned int endPoint, unsigned int observed);
+
+		// Sets the new min and max, provided they leave a usable range.
+		void applyCalibration(unsigned int batteryMin, unsigned int batteryMax);
+
 	// Members / variables.
 	// The underscore denotes a variable that belongs to the class (not a local variable).
 	protected:
@@ -112,8 +223,78 @@ class BatteryMeter
 		// Button that controls when the lights on activated.
 		SimpleButton*			_activationButton;
 
+		// Takes the readings.  NULL for analogRead.
+		BatteryMeterReadFunction	_readFunction;
+		void*					_readContext;
+
 		// The numerical value that each level has.  I.e., (batteryMax-batteryMin)/numberOfLevls.
 		float					_levelWidth;
+
+		// Supply voltage compensation.
+		bool					_vccCompensation;
+		uint32_t				_vccRefreshInterval;
+		unsigned int			_bandgap;
+
+		// The supply voltage used when it can't be measured, in millivolts, and the resolution of the readings.
+		unsigned int			_nominalVcc;
+		uint8_t					_adcBits;
+
+		// The last supply voltage measured, in millivolts, and when.  Zero if it has not been measured.
+		unsigned int			_vcc;
+		uint32_t				_lastVccRefresh;
+
+		// Automatic calibration.
+		bool					_autoCalibrate;
+
+		// Largest change, in reading units, accepted by the automatic calibration.
+		unsigned int			_calibrationMaxStep;
+
+		// Filtered reading, stored multiplied by 2^_calibrationFilterShift to keep the fractional part.
+		uint32_t				_calibrationFilter;
+
+		// The number of readings in a row rejected by the filter.  Too many means the battery really did change (for example, it
+		// was swapped) so the filter is restarted.
+		uint8_t					_calibrationRejected;
+
+		// Extremes of the filtered reading seen since the last calibration events.  Max is zero when nothing has been seen.
+		unsigned int			_observedMin;
+		unsigned int			_observedMax;
+
+		// The load reported by the application and whether it changed since loadChanged was last called.
+		unsigned int			_loadCurrent;
+		bool					_loadChanged;
+
+		// The reading and load of the last sample.  Readings taken at different loads are paired to estimate the internal resistance.
+		unsigned int			_previousReading;
+		unsigned int			_previousLoadCurrent;
+		uint32_t				_previousReadingTime;
+
+		// Estimated internal resistance (reading units per unit of current), multiplied by 2^_resistanceShift.  Zero if there is no estimate.
+		uint32_t				_internalResistance;
+
+		// Two copies of the snapshot.  The writer fills the one not in use, then switches to it by incrementing the sequence.  The low bit of the
+		// sequence is the copy in use.  A reader that sees the sequence change while copying (the writer lapped it) tries again.
+		BatteryMeterSnapshot	_snapshots[2];
+		volatile uint8_t		_snapshotSequence;
+
+		// The filter weight of a new reading is 1/2^_calibrationFilterShift.
+		static const uint8_t	_calibrationFilterShift		= 3;
+
+		// Each calibration event moves the end point 1/2^_calibrationStepShift of the way to the observed extreme.
+		static const uint8_t	_calibrationStepShift		= 2;
+
+		// The number of rejected readings in a row before the filter is restarted.
+		static const uint8_t	_calibrationMaxRejected		= 8;
+
+		// Fixed point shift of the internal resistance.
+		static const uint8_t	_resistanceShift			= 16;
+
+		// The longest time, in milliseconds, between two readings that are paired for the internal resistance.  Over longer times the
+		// battery discharges enough to be mistaken for the drop from the load.
+		static const uint16_t	_loadPairWindow				= 5000;
+
+		// The weight of a new internal resistance estimate is 1/2^_resistanceFilterShift.
+		static const uint8_t	_resistanceFilterShift		= 2;
 };
 
 #endif
\ No newline at end of file
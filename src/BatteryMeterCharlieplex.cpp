@@ -0,0 +1,235 @@
+/*
+	BatteryMeterCharlieplex
+	Library for checking a battery and displaying the results on LEDs that
+	are Charlieplexed on Arduino pins.
+	
+	Copyright (c) 2019 Lance A. Endres
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU Lesser General Public License as 
+	published by the Free Software Foundation, either version 3 of the 
+	License, or (at your option) any later version.
+	
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+	
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "BatteryMeterCharlieplex.h"
+
+BatteryMeterCharlieplex::BatteryMeterCharlieplex(unsigned int batteryMin, unsigned int batteryMax, Battery::LEVEL level) :
+	BatteryMeterWithStaticOutput<BatteryMeterCharlieplex>(batteryMin, batteryMax, level),
+	_numberOfPins(0),
+	_row(0),
+	_refreshInUpdate(true)
+{
+	for (int i = 0; i < _maxPins; i++)
+	{
+		_rowOutputs[i]	= 0;
+		_rowHigh[i]		= 0;
+	}
+
+	#if defined(__AVR__)
+		_modeRegister	= NULL;
+		_outputRegister	= NULL;
+		_portMask		= 0;
+	#endif
+}
+
+BatteryMeterCharlieplex::~BatteryMeterCharlieplex()
+{
+}
+
+void BatteryMeterCharlieplex::setCharlieplexPins(unsigned int pins[], uint8_t numberOfPins)
+{
+	// Let go of the pins from an earlier call.  The last row refreshed is still driven and would stay lit.
+	for (int i = 0; i < _numberOfPins; i++)
+	{
+		pinMode(_pins[i], INPUT);
+		digitalWrite(_pins[i], LOW);
+	}
+	for (int i = 0; i < _maxPins; i++)
+	{
+		_rowOutputs[i]	= 0;
+		_rowHigh[i]		= 0;
+	}
+	_numberOfPins	= 0;
+	_row			= 0;
+
+	// Charlieplexing needs at least two pins.  With fewer, the meter stays dark.
+	if (numberOfPins < 2)
+	{
+		return;
+	}
+
+	if (numberOfPins > _maxPins)
+	{
+		numberOfPins = _maxPins;
+	}
+	_numberOfPins = numberOfPins;
+
+	// All pins start as inputs, which turns all the lights off.
+	for (int i = 0; i < _numberOfPins; i++)
+	{
+		_pins[i] = pins[i];
+		pinMode(_pins[i], INPUT);
+		digitalWrite(_pins[i], LOW);
+	}
+
+	#ifdef BATTERYMETERDEBUG
+		if (_numberOfPins * (_numberOfPins - 1) < _maxLevel)
+		{
+			Serial.println("[BatteryMeter] Not enough Charlieplex pins for the number of levels.");
+		}
+	#endif
+
+	#if defined(__AVR__)
+		// Use the port registers directly if all the pins are on the same port.
+		_modeRegister	= portModeRegister(digitalPinToPort(_pins[0]));
+		_outputRegister	= portOutputRegister(digitalPinToPort(_pins[0]));
+		_portMask		= 0;
+		for (int i = 0; i < _numberOfPins; i++)
+		{
+			if (digitalPinToPort(_pins[i]) != digitalPinToPort(_pins[0]))
+			{
+				_modeRegister = NULL;
+			}
+			_portMask |= digitalPinToBitMask(_pins[i]);
+		}
+	#endif
+}
+
+void BatteryMeterCharlieplex::setRefreshInUpdate(bool refreshInUpdate)
+{
+	_refreshInUpdate = refreshInUpdate;
+}
+
+void BatteryMeterCharlieplex::update()
+{
+	BatteryMeterWithStaticOutput<BatteryMeterCharlieplex>::update();
+
+	if (_refreshInUpdate)
+	{
+		refresh();
+	}
+}
+
+void BatteryMeterCharlieplex::refresh()
+{
+	if (_numberOfPins == 0)
+	{
+		return;
+	}
+
+	uint8_t outputs	= _rowOutputs[_row];
+	uint8_t high	= _rowHigh[_row];
+
+	#if defined(__AVR__)
+	if (_modeRegister)
+	{
+		// Switch all our pins to inputs first so the old row doesn't ghost onto the new one, then drive the new row.
+		uint8_t oldSREG	= SREG;
+		cli();
+		*_modeRegister		&= ~_portMask;
+		*_outputRegister	= (*_outputRegister & ~_portMask) | high;
+		*_modeRegister		|= outputs;
+		SREG = oldSREG;
+	}
+	else
+	#endif
+	{
+		for (int i = 0; i < _numberOfPins; i++)
+		{
+			pinMode(_pins[i], INPUT);
+		}
+		for (int i = 0; i < _numberOfPins; i++)
+		{
+			if (outputs & (1 << i))
+			{
+				digitalWrite(_pins[i], (high & (1 << i)) ? HIGH : LOW);
+				pinMode(_pins[i], OUTPUT);
+			}
+			else
+			{
+				digitalWrite(_pins[i], LOW);
+			}
+		}
+	}
+
+	_row++;
+	if (_row >= _numberOfPins)
+	{
+		_row = 0;
+	}
+}
+
+uint8_t BatteryMeterCharlieplex::pinBit(uint8_t pin)
+{
+	#if defined(__AVR__)
+	if (_modeRegister)
+	{
+		return digitalPinToBitMask(_pins[pin]);
+	}
+	#endif
+
+	return 1 << pin;
+}
+
+void BatteryMeterCharlieplex::setLights(Battery::LEVEL level)
+{
+	if (_numberOfPins < 2)
+	{
+		return;
+	}
+
+	uint8_t outputs[_maxPins];
+	uint8_t high[_maxPins];
+	for (int row = 0; row < _numberOfPins; row++)
+	{
+		outputs[row]	= 0;
+		high[row]		= 0;
+	}
+
+	// Each row (anode) has one light for every other pin.
+	int lightsPerRow	= _numberOfPins - 1;
+	int lights			= level;
+	if (lights > _numberOfPins * lightsPerRow)
+	{
+		lights = _numberOfPins * lightsPerRow;
+	}
+
+	for (int light = 0; light < lights; light++)
+	{
+		// The cathodes skip over the anode pin.
+		int anode	= light / lightsPerRow;
+		int cathode	= light % lightsPerRow;
+		if (cathode >= anode)
+		{
+			cathode++;
+		}
+
+		outputs[anode]	|= pinBit(anode) | pinBit(cathode);
+		high[anode]		|= pinBit(anode);
+
+		#ifdef BATTERYMETERDEBUG
+			Serial.print("[BatteryMeter] Level: ");
+			Serial.print(light + 1);
+			Serial.print("    Anode pin: ");
+			Serial.print(_pins[anode]);
+			Serial.print("    Cathode pin: ");
+			Serial.println(_pins[cathode]);
+		#endif
+	}
+
+	// Copy the finished rows for the refresh.  A refresh interrupting this shows one row of a mix of the old and new
+	// level, which is too short to see.
+	for (int row = 0; row < _numberOfPins; row++)
+	{
+		_rowOutputs[row]	= outputs[row];
+		_rowHigh[row]		= high[row];
+	}
+}
\ No newline at end of file
@@ -0,0 +1,118 @@
+/*
+	BatteryMeterCharlieplex
+	Library for checking a battery and displaying the results on LEDs that
+	are Charlieplexed on Arduino pins.
+	
+	Copyright (c) 2019 Lance A. Endres
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU Lesser General Public License as 
+	published by the Free Software Foundation, either version 3 of the 
+	License, or (at your option) any later version.
+	
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+	
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*
+	Drives the lights with Charlieplexing.  Each light is connected between two pins, so "n" pins can drive n*(n-1) lights:
+		3 pins	-> 6 lights
+		4 pins	-> 12 lights (enough for LEVEL10)
+
+	The lights are numbered with the anode (positive) pin changing slowest.  For 3 pins (A, B, C):
+		Light	Anode	Cathode
+		1		A		B
+		2		A		C
+		3		B		A
+		4		B		C
+		5		C		A
+		6		C		B
+
+	Only one anode pin (a row) is driven at a time, so the lights have to be refreshed continuously.  Each call to refresh
+	lights the next row.  Each light is on 1/n of the time, and the full display refreshes once every n calls.  To avoid
+	flicker, the display should refresh at least 60 times a second, for example, call refresh every 4 ms for 4 pins.
+
+	Every pin needs a current limiting resistor.  The anode pin carries the current for all the lights on in its row.
+*/
+
+#ifndef BATTERYMETERCHARLIEPLEX_H
+#define BATTERYMETERCHARLIEPLEX_H
+
+#include <Arduino.h>
+#include "BatteryMeterWithStaticOutput.h"
+
+class BatteryMeterCharlieplex : public BatteryMeterWithStaticOutput<BatteryMeterCharlieplex>
+{
+	// The base class calls setLights.
+	friend class BatteryMeterWithStaticOutput<BatteryMeterCharlieplex>;
+
+	// Constructors.
+	public:
+		// Constructor.
+		BatteryMeterCharlieplex(unsigned int batteryMin, unsigned int batteryMax, Battery::LEVEL level);
+
+		// Default destructor.
+		~BatteryMeterCharlieplex();
+
+	// Setup functions.  Create your instance and run these functions in your "setup" routine.
+	public:
+		// Set the pins the lights are connected between.  Use this instead of setLightPins.  2 to 5 pins can be used.
+		void setCharlieplexPins(unsigned int pins[], uint8_t numberOfPins);
+
+	// Optional settings.
+	public:
+		// By default, update refreshes the display.  If refresh is called from a timer interrupt instead, turn this off.
+		void setRefreshInUpdate(bool refreshInUpdate);
+
+	// Loop functions.  Run these functions in your "loop" routine.
+	public:
+		// Meters the battery (see BatteryMeterWithStaticOutput) and refreshes the display.
+		void update();
+
+		// Lights the next row.  This is a short, fixed amount of work and is safe to call from a timer interrupt.
+		void refresh();
+
+	// Private functions.  The user need not worry about these.
+	private:
+		// Builds the rows for the level.  The refresh only copies the rows to the pins.
+		void setLights(Battery::LEVEL level);
+
+		// The bit used for a pin in the rows.
+		uint8_t pinBit(uint8_t pin);
+
+	// Members / variables.
+	// The underscore denotes a variable that belongs to the class (not a local variable).
+	private:
+		// The most pins supported.  5 pins is 20 lights, more than the largest LEVEL.
+		static const uint8_t	_maxPins	= 5;
+
+		// The Arduino pins.
+		uint8_t					_pins[_maxPins];
+		uint8_t					_numberOfPins;
+
+		// For each row, the pins that are outputs and the pins that are driven high.  The rest are inputs (high impedance).
+		volatile uint8_t		_rowOutputs[_maxPins];
+		volatile uint8_t		_rowHigh[_maxPins];
+
+		// The row the next refresh will light.
+		uint8_t					_row;
+
+		// Whether update calls refresh.
+		bool					_refreshInUpdate;
+
+		#if defined(__AVR__)
+		// When all the pins are on one port, the rows are written straight to the port registers.  The row bits are then the
+		// port bits, and "_portMask" is all the port bits we use.  Otherwise, "_modeRegister" is NULL and the bits are the
+		// indices into "_pins."
+		volatile uint8_t*		_modeRegister;
+		volatile uint8_t*		_outputRegister;
+		uint8_t					_portMask;
+		#endif
+};
+
+#endif
\ No newline at end of file
@@ -24,7 +24,7 @@
 #include "BatteryMeterPins.h"
 
 BatteryMeterPins::BatteryMeterPins(unsigned int batteryMin, unsigned int batteryMax, Battery::LEVEL level) :
-	BatteryMeterWithOutput(batteryMin, batteryMax, level)
+	BatteryMeterWithStaticOutput<BatteryMeterPins>(batteryMin, batteryMax, level)
 {
 }
 
@@ -34,7 +34,7 @@ BatteryMeterPins::~BatteryMeterPins()
 
 void BatteryMeterPins::setLightPins(unsigned int ledPins[], uint8_t ledOnLevel)
 {
-	BatteryMeterWithOutput::setLightPins(ledPins, ledOnLevel);
+	BatteryMeterWithStaticOutput<BatteryMeterPins>::setLightPins(ledPins, ledOnLevel);
 
 	// The long winded, but API appropriate way to specify write levels.
 	uint8_t initialLevel = LOW;
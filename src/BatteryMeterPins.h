@@ -33,10 +33,13 @@
 #define BATTERYMETERPINS_H
 
 #include <Arduino.h>
-#include "BatteryMeterWithOutput.h"
+#include "BatteryMeterWithStaticOutput.h"
 
-class BatteryMeterPins : public BatteryMeterWithOutput
+class BatteryMeterPins : public BatteryMeterWithStaticOutput<BatteryMeterPins>
 {
+	// The base class calls setLights.
+	friend class BatteryMeterWithStaticOutput<BatteryMeterPins>;
+
 	// Constructors.
 	public:
 		// Constructor.
@@ -37,11 +37,14 @@
 
 #include <Arduino.h>
 #include "ShiftRegister74HC595.h"
-#include "BatteryMeterWithOutput.h"
+#include "BatteryMeterWithStaticOutput.h"
 
 template <uint8_t numberOfShiftRegisters>
-class BatteryMeterShiftRegister : public BatteryMeterWithOutput
+class BatteryMeterShiftRegister : public BatteryMeterWithStaticOutput<BatteryMeterShiftRegister<numberOfShiftRegisters> >
 {
+	// The base class calls setLights.
+	friend class BatteryMeterWithStaticOutput<BatteryMeterShiftRegister<numberOfShiftRegisters> >;
+
 	// Constructors. 
 	public:
 		// Constructor.
@@ -23,7 +23,7 @@
 
 template <uint8_t numberOfShiftRegisters>
 BatteryMeterShiftRegister<numberOfShiftRegisters>::BatteryMeterShiftRegister(ShiftRegister74HC595<numberOfShiftRegisters>* shiftRegister, unsigned int batteryMin, unsigned int batteryMax, Battery::LEVEL level) :
-	BatteryMeterWithOutput(batteryMin, batteryMax, level),
+	BatteryMeterWithStaticOutput<BatteryMeterShiftRegister<numberOfShiftRegisters> >(batteryMin, batteryMax, level),
 	_shiftRegister(shiftRegister)
 {
 }
@@ -41,24 +41,24 @@ void BatteryMeterShiftRegister<numberOfShiftRegisters>::setLights(Battery::LEVEL
 	for (int i = 0; i < level; i++)
 	{
 		#ifdef BATTERYMETERDEBUG
-			printPinState(i, true);
+			this->printPinState(i, true);
 		#endif
-		_shiftRegister->setNoUpdate(_ledPins[i], _ledOnLevel);
+		_shiftRegister->setNoUpdate(this->_ledPins[i], this->_ledOnLevel);
 	}
 
 	uint8_t ledOffLevel = LOW;
-	if (_ledOnLevel == LOW)
+	if (this->_ledOnLevel == LOW)
 	{
 		ledOffLevel = HIGH;
 	}
 
 	// Turn off the rest of the lights.
-	for (int i = level; i < _maxLevel; i++)
+	for (int i = level; i < this->_maxLevel; i++)
 	{
 		#ifdef BATTERYMETERDEBUG
-			printPinState(i, false);
+			this->printPinState(i, false);
 		#endif
-		_shiftRegister->setNoUpdate(_ledPins[i], ledOffLevel);
+		_shiftRegister->setNoUpdate(this->_ledPins[i], ledOffLevel);
 	}
 
 	// Now that all the bit values are set for the lights, activate them.
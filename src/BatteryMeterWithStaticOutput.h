@@ -0,0 +1,182 @@
+/*
+	The MIT License (MIT)
+	
+	Copyright (c) 2019 Lance A. Endres
+	
+	Permission is hereby granted, free of charge, to any person obtaining a copy of
+	this software and associated documentation files (the "Software"), to deal in
+	the Software without restriction, including without limitation the rights to
+	use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+	the Software, and to permit persons to whom the Software is furnished to do so,
+	subject to the following conditions:
+	
+	The above copyright notice and this permission notice shall be included in all
+	copies or substantial portions of the Software.
+	
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+	FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+	COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+	IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+	CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+/*
+	Provides the base functionality for using output lights with the battery meter.
+
+	The output is selected at compile time.  The template argument is the derived class, which must provide:
+		void setLights(Battery::LEVEL level);
+	The call is resolved statically, so there is no virtual function table and the call can be inlined.  If the
+	derived class makes setLights private, it needs to make this class a friend.  BatteryMeterWithOutput is the
+	version with a virtual setLights, for output classes that need to be used through a base class pointer.
+*/
+
+#ifndef BATTERYMETERWITHSTATICOUTPUT_H
+#define BATTERYMETERWITHSTATICOUTPUT_H
+
+#include <Arduino.h>
+#include "SoftTimers.h"
+#include "BatteryMeter.h"
+
+template <class outputClass>
+class BatteryMeterWithStaticOutput : public BatteryMeter
+{
+	// Constructors and destructor.
+	public:
+		// Constructor.
+		BatteryMeterWithStaticOutput(unsigned int batteryMin, unsigned int batteryMax, Battery::LEVEL level);
+
+		// Default destructor.
+		~BatteryMeterWithStaticOutput();
+
+	// Required setup functions.  Run these functions in your "setup" routine.
+	public:
+		// This determines how the battery meter is activated (turns lights on).  Depending on class type passed (a class
+		// derived from SimpleButton).  Both functions do the same thing, they just allow the argument to be passed in
+		// different ways.
+		void setActivationButton(SimpleButton* activationButton);
+		void setActivationButton(SimpleButton& activationButton);
+
+		// Set the pins the lights are on.  The number of entries in ledPins should match the LEVEL used in the constructor.
+		void setLightPins(unsigned int ledPins[], uint8_t ledOnLevel);
+
+		// Initialization.  Run this after the other setup functions.
+		void begin();
+
+	// Optional settings.
+	public:
+		// The time between battery readings and updating lights.  This turns off the adaptive update interval.
+		void setUpdateInterval(uint32_t updateInterval);
+
+		// Lets the time between readings adapt to what the battery is doing.  When the reading is changing quickly or the load reported
+		// with setLoadCurrent or setLoaded changes, the interval drops to "minInterval."  When the reading is steady, the interval doubles
+		// with each reading until it reaches "maxInterval."  "changeThreshold" is the change in reading (per minInterval) that is considered
+		// quick.  Set it above the noise in the readings.  The min interval must be at least 1 ms and the max is raised to the min if it
+		// is smaller.
+		void setAdaptiveUpdateInterval(uint32_t minInterval, uint32_t maxInterval, unsigned int changeThreshold = 4);
+
+	// Display effects.  These are all run from update, a small step at a time, so they never hold up the loop.
+	public:
+		// Time, in milliseconds, to move the lights one level when the level changes (including turning off when the
+		// button is released).  Zero, the default, changes immediately.
+		void setTransitionTime(uint16_t transitionTime);
+
+		// Shows the battery is charging.  While the meter is on, the lights above the level turn on one at a time and then
+		// start over.  "sweepTime" is the time, in milliseconds, between lights.
+		void setCharging(bool charging, uint16_t sweepTime = 250);
+
+		// Blinks the lights while the level is at or below "lowLevel."  LEVEL0 turns blinking off.  "blinkTime" is the time,
+		// in milliseconds, the lights are on (and off).
+		void setLowBatteryBlink(Battery::LEVEL lowLevel, uint16_t blinkTime = 500);
+
+		// Dims the lights with software PWM, 255 is full brightness.  The lights are switched from update, so it must be called
+		// often (at least every few hundred microseconds) or the lights will flicker.  Each update switches the lights at most once.
+		void setBrightness(uint8_t brightness);
+
+	// Loop functions.  Run these functions in your "loop" routine.
+	public:
+		// Entry point to the battery meter.  Checks for any state changes and updates accordingly.  This runs on a timer and only updates
+		// on a time out.  This is prevent flickering of the lights when the battery measurement is near the border of two levels.  The
+		// reading has a small variablity to it.
+		void update();
+
+		// If you need to run the meter immediately and not wait for the time out, use this version.
+		void updateNow();
+
+	// Protected debugging functions.  Used by the derived classes.
+	protected:
+		#ifdef BATTERYMETERDEBUG
+		// Print the state of a pin.
+		void printPinState(int pin, bool on);
+		#endif
+
+	// Private functions.  The user need not worry about these.
+	private:
+		// The main work of finding the level and setting the lights.
+		void meter(bool forcedRun);
+
+		// Works out what the lights should show right now and sets them if that changed.
+		void render();
+
+		// Picks the next update interval based on how the reading has changed.
+		void adaptUpdateInterval(float sensePinReading);
+
+		// The derived class that does the output.
+		outputClass& output();
+
+	// Members / variables.
+	// The underscore denotes a variable that belongs to the class (not a local variable).
+	protected:
+		// LED output pins.
+		unsigned int*			_ledPins;
+
+		// The level (HIGH or LOW) to use to turn the LEDs on.
+		uint8_t					_ledOnLevel;
+
+	private:
+		// Button that controls when the lights on activated.
+		SimpleButton*			_activationButton;
+
+		// Used to prevent the meter level from bouncing around if the reading is between two levels.
+		SoftTimer				_updateTimer;
+
+		// Adaptive update interval bounds.  A max of zero means the interval is fixed.
+		uint32_t				_minUpdateInterval;
+		uint32_t				_maxUpdateInterval;
+
+		// Change in reading considered significant by the adaptive update interval.
+		unsigned int			_changeThreshold;
+
+		// The reading from the last update and when it was taken.  The reading is negative when there has not been one.
+		float					_lastReading;
+		uint32_t				_lastReadingTime;
+
+		// Whether the meter is on (the button is pressed).
+		bool					_active;
+
+		// The level from the last reading, the level the transition has reached, and what the lights are showing now.
+		Battery::LEVEL			_targetLevel;
+		Battery::LEVEL			_displayedLevel;
+		Battery::LEVEL			_renderedLevel;
+
+		// Level transition.  The time is zero for immediate changes.
+		uint16_t				_transitionTime;
+		uint32_t				_lastTransitionStep;
+
+		// Charging sweep.
+		bool					_charging;
+		uint16_t				_sweepTime;
+
+		// Low battery blinking.  LEVEL0 is off.
+		Battery::LEVEL			_lowLevel;
+		uint16_t				_blinkTime;
+
+		// Software PWM brightness.
+		uint8_t					_brightness;
+};
+
+// Definitions are stored in another file, so we have to include it here.  This allows us to separate the interface
+// and definitions while using a template.  Normally, all the code has to go into the header file for a template.
+#include "BatteryMeterWithStaticOutput.hpp"
+
+#endif
\ No newline at end of file
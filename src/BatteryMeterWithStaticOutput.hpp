@@ -0,0 +1,384 @@
+/*
+	The MIT License (MIT)
+	
+	Copyright (c) 2019 Lance A. Endres
+	
+	Permission is hereby granted, free of charge, to any person obtaining a copy of
+	this software and associated documentation files (the "Software"), to deal in
+	the Software without restriction, including without limitation the rights to
+	use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+	the Software, and to permit persons to whom the Software is furnished to do so,
+	subject to the following conditions:
+	
+	The above copyright notice and this permission notice shall be included in all
+	copies or substantial portions of the Software.
+	
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+	FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+	COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+	IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+	CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+// Constructor.
+template <class outputClass>
+BatteryMeterWithStaticOutput<outputClass>::BatteryMeterWithStaticOutput(unsigned int batteryMin, unsigned int batteryMax, Battery::LEVEL maxLevel) :
+	BatteryMeter(batteryMin, batteryMax, maxLevel),
+	_ledPins(NULL),
+	_ledOnLevel(HIGH),
+	_minUpdateInterval(0),
+	_maxUpdateInterval(0),
+	_changeThreshold(0),
+	_lastReading(-1),
+	_lastReadingTime(0),
+	_active(false),
+	_targetLevel(Battery::LEVEL0),
+	_displayedLevel(Battery::LEVEL0),
+	_renderedLevel(Battery::LEVEL0),
+	_transitionTime(0),
+	_lastTransitionStep(0),
+	_charging(false),
+	_sweepTime(250),
+	_lowLevel(Battery::LEVEL0),
+	_blinkTime(500),
+	_brightness(255)
+{
+  _updateTimer.setTimeOutTime(120000);
+}
+
+template <class outputClass>
+BatteryMeterWithStaticOutput<outputClass>::~BatteryMeterWithStaticOutput()
+{
+	if (_ledPins)
+	{
+		delete[] _ledPins;
+	}
+}
+
+template <class outputClass>
+void BatteryMeterWithStaticOutput<outputClass>::setActivationButton(SimpleButton* activationButton)
+{
+	_activationButton	= activationButton;
+}
+
+template <class outputClass>
+void BatteryMeterWithStaticOutput<outputClass>::setActivationButton(SimpleButton& activationButton)
+{
+	_activationButton	= &activationButton;
+}
+
+template <class outputClass>
+void BatteryMeterWithStaticOutput<outputClass>::setLightPins(unsigned int ledPins[], uint8_t ledOnLevel)
+{
+	_ledPins	= new unsigned int[_maxLevel];
+	_ledOnLevel	= ledOnLevel;
+
+	// We will make a copy of the values to keep the user from accidently deleting the memory.
+	for (int i = 0; i < _maxLevel; i++)
+	{
+		_ledPins[i] = ledPins[i];
+	}
+}
+
+template <class outputClass>
+void BatteryMeterWithStaticOutput<outputClass>::begin()
+{
+	BatteryMeter::begin();
+
+	// If the button is already on, we need to run the meter once so it starts immediately without
+	// waiting for the timer to complete.  Otherwise, a delay will occur.
+	BUTTONSTATUS buttonStatus = _activationButton->getStatus();
+	if (buttonStatus == ISPRESSED || buttonStatus == WASPRESSED)
+	{
+		meter(true);
+	}
+
+	#ifdef BATTERYMETERDEBUG
+		// Outputs that don't use one pin per light (Charlieplexing, for example) don't set the light pins.
+		if (_ledPins)
+		{
+			Serial.print("[BatteryMeter] Light pins:");
+			for (int i = 0; i < _maxLevel; i++)
+			{
+				Serial.print(" ");
+				Serial.print(_ledPins[i]);
+			}
+
+			// Print end of line since we don't return after printing the pins above.
+			Serial.println("");
+		}
+	#endif
+}
+
+template <class outputClass>
+void BatteryMeterWithStaticOutput<outputClass>::setUpdateInterval(uint32_t updateInterval)
+{
+	_updateTimer.setTimeOutTime(updateInterval);
+	_maxUpdateInterval = 0;
+}
+
+template <class outputClass>
+void BatteryMeterWithStaticOutput<outputClass>::setAdaptiveUpdateInterval(uint32_t minInterval, uint32_t maxInterval, unsigned int changeThreshold)
+{
+	// A zero interval would read the battery on every loop.
+	if (minInterval == 0)
+	{
+		minInterval = 1;
+	}
+	if (maxInterval < minInterval)
+	{
+		maxInterval = minInterval;
+	}
+
+	_minUpdateInterval	= minInterval;
+	_maxUpdateInterval	= maxInterval;
+	_changeThreshold	= changeThreshold;
+
+	// Forget the last reading so an old value isn't mistaken for a change.
+	_lastReading		= -1;
+
+	// Start fast, we know nothing about the battery yet.
+	_updateTimer.setTimeOutTime(minInterval);
+}
+
+template <class outputClass>
+void BatteryMeterWithStaticOutput<outputClass>::update()
+{
+	switch (_activationButton->getStatus())
+	{
+		case WASPRESSED:
+		{
+			// The button was just pressed, meter immediately.
+			#ifdef BATTERYMETERDEBUG
+				Serial.println("[BatteryMeter] Button Status: WASPRESSED");
+			#endif
+			meter(true);
+			break;
+		}
+
+		case ISPRESSED:
+		{
+			// The button is pressed, meter when the timer is up.
+			meter(false);
+			break;
+		}
+		
+		case WASSHORTPRESSED:
+		case WASLONGPRESSED:
+		{
+			// The button was just released, meter immediately.
+			#ifdef BATTERYMETERDEBUG
+				Serial.println("[BatteryMeter] Button Status: WASSHORTPRESSED or WASLONGPRESSED");
+			#endif
+			// Get new status.
+			BUTTONSTATUS newStatus = _activationButton->getStatus();
+			if (newStatus == BUTTONSTATUS::NOTPRESSED)
+			{
+				// Turn the lights off (through the transition, if there is one).
+				_active			= false;
+				_targetLevel	= Battery::LEVEL0;
+			}
+			break;
+		}
+
+		case NOTPRESSED:
+		{
+			// The button is not pressed, do nothing.
+			break;
+		}
+	}
+
+	// Run the next step of any display effects.
+	render();
+}
+
+template <class outputClass>
+void BatteryMeterWithStaticOutput<outputClass>::setTransitionTime(uint16_t transitionTime)
+{
+	_transitionTime = transitionTime;
+}
+
+template <class outputClass>
+void BatteryMeterWithStaticOutput<outputClass>::setCharging(bool charging, uint16_t sweepTime)
+{
+	_charging	= charging;
+	_sweepTime	= sweepTime;
+}
+
+template <class outputClass>
+void BatteryMeterWithStaticOutput<outputClass>::setLowBatteryBlink(Battery::LEVEL lowLevel, uint16_t blinkTime)
+{
+	_lowLevel	= lowLevel;
+	_blinkTime	= blinkTime;
+}
+
+template <class outputClass>
+void BatteryMeterWithStaticOutput<outputClass>::setBrightness(uint8_t brightness)
+{
+	_brightness = brightness;
+}
+
+template <class outputClass>
+void BatteryMeterWithStaticOutput<outputClass>::updateNow()
+{
+	// We need an immediate metering, for run meter with forcedRun set to true.
+	meter(true);
+}
+
+#ifdef BATTERYMETERDEBUG
+template <class outputClass>
+void BatteryMeterWithStaticOutput<outputClass>::printPinState(int pin, bool on)
+{
+	Serial.print("[BatteryMeter] Level: ");
+	Serial.print(pin + 1);
+	Serial.print("    Pin: ");
+	Serial.print(_ledPins[pin]);
+	Serial.print("    ");
+	if (on)
+	{
+		Serial.println("On");
+	}
+	else
+	{
+		Serial.println("Off");
+	}
+}
+#endif
+
+template <class outputClass>
+void BatteryMeterWithStaticOutput<outputClass>::meter(bool forcedRun)
+{
+	// A change in the load changes the reading, so don't wait out a long interval to see it.
+	if (_maxUpdateInterval && loadChanged())
+	{
+		_updateTimer.setTimeOutTime(_minUpdateInterval);
+	}
+
+	// If the timer is up we run.  If we have specified "forcedRun" it means run regardless
+	// of whether the timer is up or not.
+	if (_updateTimer.hasTimedOut() || forcedRun)
+	{
+		
+		float sensePinReading	= readSensePin();
+		Battery::LEVEL level	= convertReadingToLevel(sensePinReading);
+
+		// Set the lights.
+		_active			= true;
+		_targetLevel	= level;
+		render();
+
+		// Let interrupts and other contexts see the new state.
+		publishSnapshot(sensePinReading, level);
+
+		if (_maxUpdateInterval)
+		{
+			adaptUpdateInterval(sensePinReading);
+		}
+
+		// Restart the timer.
+		_updateTimer.reset();
+
+		// We we are dubugging, print the level.  LEVEL is zero based so we add one
+		// to get the human version.
+		#ifdef BATTERYMETERDEBUG
+			Serial.print("[BatteryMeter] Battery level: ");
+			Serial.println(level);
+		#endif
+	}
+}
+
+template <class outputClass>
+void BatteryMeterWithStaticOutput<outputClass>::render()
+{
+	uint32_t now = millis();
+
+	// Move one level at a time toward the level read.
+	if (_displayedLevel != _targetLevel)
+	{
+		if (_transitionTime == 0)
+		{
+			_displayedLevel = _targetLevel;
+		}
+		else if (now - _lastTransitionStep >= _transitionTime)
+		{
+			_displayedLevel		= (Battery::LEVEL)(_displayedLevel < _targetLevel ? _displayedLevel + 1 : _displayedLevel - 1);
+			_lastTransitionStep	= now;
+		}
+	}
+
+	Battery::LEVEL level = _displayedLevel;
+
+	// The effects only run once a transition has finished.
+	if (_active && _displayedLevel == _targetLevel)
+	{
+		if (_charging && _sweepTime)
+		{
+			// Add one light above the level each step, wrapping back to the level after the top light.
+			uint8_t steps	= _maxLevel - _displayedLevel + 1;
+			level			= (Battery::LEVEL)(_displayedLevel + (now / _sweepTime) % steps);
+		}
+		else if (_displayedLevel <= _lowLevel && _blinkTime && (now / _blinkTime) % 2)
+		{
+			level = Battery::LEVEL0;
+		}
+	}
+
+	// Software PWM.  The period is 256 steps of 16 microseconds (about 4 ms).
+	if (_brightness < 255 && ((micros() >> 4) & 0xFF) >= _brightness)
+	{
+		level = Battery::LEVEL0;
+	}
+
+	// Only touch the outputs when something changed.
+	if (level != _renderedLevel)
+	{
+		output().setLights(level);
+		_renderedLevel = level;
+	}
+}
+
+template <class outputClass>
+void BatteryMeterWithStaticOutput<outputClass>::adaptUpdateInterval(float sensePinReading)
+{
+	uint32_t now			= millis();
+	uint32_t interval		= _updateTimer.getTimeOutTime();
+	float change			= _lastReading < 0 ? _changeThreshold : fabs(sensePinReading - _lastReading);
+
+	// Use the time that really passed, forced and late updates don't happen on the interval.  Anything shorter than
+	// the min interval is treated as the min interval so back to back readings don't look like a fast change.
+	uint32_t elapsed		= now - _lastReadingTime;
+	if (elapsed < _minUpdateInterval)
+	{
+		elapsed = _minUpdateInterval;
+	}
+
+	_lastReading			= sensePinReading;
+	_lastReadingTime		= now;
+
+	// Compare the rate of change instead of the change so a slow drift over a long interval is not mistaken for
+	// a quick change.  I.e., change/elapsed >= threshold/minInterval.
+	if (change * _minUpdateInterval >= (float)_changeThreshold * elapsed)
+	{
+		interval = _minUpdateInterval;
+	}
+	else
+	{
+		// Back off, without going past the max (or overflowing).
+		interval = interval > _maxUpdateInterval / 2 ? _maxUpdateInterval : interval * 2;
+	}
+
+	_updateTimer.setTimeOutTime(interval);
+
+	#ifdef BATTERYMETERDEBUG
+		Serial.print("[BatteryMeter] Update interval: ");
+		Serial.println(interval);
+	#endif
+}
+
+template <class outputClass>
+inline outputClass& BatteryMeterWithStaticOutput<outputClass>::output()
+{
+	// Curiously recurring template pattern.  We are the base of outputClass, so this is always safe.
+	return *static_cast<outputClass*>(this);
+}
\ No newline at end of file